@@ -0,0 +1,196 @@
+#include "Baseline.h"
+
+Baseline::Baseline(std::string backend, std::string device, std::vector<Measurement> const &measurements) :
+_backend(std::move(backend)), _device(std::move(device)) {
+    for (auto &measurement : measurements) {
+        _measurements[measurement.name] = measurement;
+    }
+}
+
+bool Baseline::save(std::string path) {
+    nlohmann::json j;
+    j["backend"] = _backend;
+    j["device"] = _device;
+
+    nlohmann::json benchmarks = nlohmann::json::object();
+    for (auto &[name, measurement] : _measurements) {
+        nlohmann::json entry;
+        entry["median"] = measurement.median();
+        entry["p95"] = measurement.p95();
+        entry["memory"] = measurement.peakDeviceBytes;
+        // The raw samples are needed for the significance test
+        entry["samples"] = measurement.samples;
+        benchmarks[name] = entry;
+    }
+    j["benchmarks"] = benchmarks;
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << path << "\n";
+        return false;
+    }
+    file << j.dump(4);
+    file.close();
+    return true;
+}
+
+bool Baseline::load(std::string path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for reading: " << path << "\n";
+        return false;
+    }
+
+    nlohmann::json j;
+    try {
+        file >> j;
+    } catch (const nlohmann::json::exception &e) {
+        std::cerr << "JSON parse error: " << e.what() << "\n";
+        file.close();
+        return false;
+    }
+    file.close();
+
+    _backend = j["backend"].get<std::string>();
+    _device = j["device"].get<std::string>();
+    _measurements.clear();
+
+    for (auto &[name, entry] : j["benchmarks"].items()) {
+        Measurement measurement;
+        measurement.name = name;
+        measurement.samples = entry["samples"].get<std::vector<float>>();
+        measurement.peakDeviceBytes = entry["memory"].get<size_t>();
+        _measurements[name] = measurement;
+    }
+
+    return true;
+}
+
+bool Baseline::compare(std::vector<Measurement> const &current, Thresholds const &thresholds, std::string const &backend,
+                       std::string const &device) {
+    bool passed = true;
+
+    std::cout << "Comparing against the baseline recorded on " << _device << " (" << _backend << ")\n";
+
+    // Timings of another backend or device say nothing about a regression
+    if (backend != _backend || device != _device) {
+        std::cerr << "The baseline was recorded on " << _device << " (" << _backend << "), but this run uses "
+                  << device << " (" << backend << "), record a baseline for this machine first!\n";
+        return false;
+    }
+
+    for (auto &measurement : current) {
+        auto it = _measurements.find(measurement.name);
+        if (it == _measurements.end()) {
+            std::cout << measurement.name << ": no baseline, skipped\n";
+            continue;
+        }
+        Measurement &baseline = it->second;
+
+        float medianChange = measurement.median() / baseline.median() - 1.0f;
+        float p95Change = measurement.p95() / baseline.p95() - 1.0f;
+        float memoryChange = baseline.peakDeviceBytes > 0 ?
+                (float)measurement.peakDeviceBytes / (float)baseline.peakDeviceBytes - 1.0f : 0.0f;
+
+        // Timings only count as slower if the shift is significant, otherwise it is just noise
+        float p = mannWhitney(baseline.samples, measurement.samples);
+        bool significant = p < thresholds.alpha;
+
+        std::vector<std::string> reasons;
+        if (significant && medianChange > thresholds.median) {
+            reasons.emplace_back("median");
+        }
+        if (significant && p95Change > thresholds.p95) {
+            reasons.emplace_back("p95");
+        }
+        if (memoryChange > thresholds.memory) {
+            reasons.emplace_back("memory");
+        }
+
+        std::cout << measurement.name << ": median " << std::showpos << medianChange * 100.0f << "%, p95 "
+                  << p95Change * 100.0f << "%, memory " << memoryChange * 100.0f << "%" << std::noshowpos
+                  << ", p = " << p;
+
+        if (reasons.empty()) {
+            std::cout << " -> ok\n";
+        } else {
+            passed = false;
+            std::cout << " -> REGRESSION (";
+            for (size_t i = 0; i < reasons.size(); ++i) {
+                std::cout << (i > 0 ? ", " : "") << reasons[i];
+            }
+            std::cout << ")\n";
+        }
+    }
+
+    return passed;
+}
+
+float Baseline::percentile(std::vector<float> samples, float p) {
+    if (samples.empty()) {
+        return 0.0f;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    // Linear interpolation between the closest ranks
+    float rank = p * (float)(samples.size() - 1);
+    size_t lower = (size_t)std::floor(rank);
+    size_t upper = std::min(lower + 1, samples.size() - 1);
+    float fraction = rank - (float)lower;
+
+    return samples[lower] + fraction * (samples[upper] - samples[lower]);
+}
+
+float Baseline::mannWhitney(std::vector<float> const &baseline, std::vector<float> const &current) {
+    // One-sided test whether the current samples tend to be larger (slower) than the baseline
+    size_t n1 = baseline.size();
+    size_t n2 = current.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0f;
+    }
+
+    // Rank all samples together, ties get their average rank
+    std::vector<std::pair<float, int>> all;
+    all.reserve(n1 + n2);
+    for (float value : baseline) {
+        all.emplace_back(value, 0);
+    }
+    for (float value : current) {
+        all.emplace_back(value, 1);
+    }
+    std::sort(all.begin(), all.end());
+
+    double rankSum = 0.0;
+    double tieCorrection = 0.0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+
+        double rank = (double)(i + j + 1) / 2.0; // Ranks start at 1
+        for (size_t k = i; k < j; ++k) {
+            if (all[k].second == 1) {
+                rankSum += rank;
+            }
+        }
+
+        double ties = (double)(j - i);
+        tieCorrection += ties * ties * ties - ties;
+        i = j;
+    }
+
+    double n = (double)(n1 + n2);
+    double u = rankSum - (double)n2 * ((double)n2 + 1.0) / 2.0;
+    double mean = (double)n1 * (double)n2 / 2.0;
+    double variance = (double)n1 * (double)n2 / 12.0 * ((n + 1.0) - tieCorrection / (n * (n - 1.0)));
+
+    if (variance <= 0.0) {
+        return 1.0f;
+    }
+
+    // Normal approximation with continuity correction
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return (float)(0.5 * std::erfc(z / std::sqrt(2.0)));
+}
@@ -0,0 +1,55 @@
+#ifndef KI_BASELINE_H
+#define KI_BASELINE_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include "../../vendors/json/json.hpp"
+
+class Baseline {
+public:
+    // Repeated timings of one benchmark
+    struct Measurement {
+        std::string name;
+        std::vector<float> samples; // Seconds per sample
+        size_t peakDeviceBytes = 0;
+
+        [[nodiscard]] float median() const { return percentile(samples, 0.5f); }
+        [[nodiscard]] float p95() const { return percentile(samples, 0.95f); }
+    };
+
+    // Relative slowdowns that count as a regression (0.1 = 10% slower)
+    struct Thresholds {
+        float median = 0.10f;
+        float p95 = 0.25f;
+        float memory = 0.10f;
+        float alpha = 0.01f; // Significance level of the Mann-Whitney test
+    };
+
+private:
+    std::string _backend;
+    std::string _device;
+    std::map<std::string, Measurement> _measurements;
+
+public:
+    Baseline() = default;
+    Baseline(std::string backend, std::string device, std::vector<Measurement> const &measurements);
+
+    bool load(std::string path);
+    bool save(std::string path);
+
+    // Prints a report and returns false if any benchmark regressed or the baseline was recorded on another backend or device
+    bool compare(std::vector<Measurement> const &current, Thresholds const &thresholds, std::string const &backend,
+                 std::string const &device);
+
+    // Statistics
+    static float percentile(std::vector<float> samples, float p);
+    static float mannWhitney(std::vector<float> const &baseline, std::vector<float> const &current);
+};
+
+
+#endif //KI_BASELINE_H
@@ -0,0 +1,223 @@
+#include "Benchmark.h"
+
+Benchmark::Benchmark(std::vector<int> topology, std::vector<Utility::Activations> activations) :
+_topology(std::move(topology)), _activations(std::move(activations)) {
+}
+
+void Benchmark::createDataset(int points, unsigned int seed, af::array &inputs, af::array &targets) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+
+    std::vector<float> positions(2 * points);
+    std::vector<float> classes(2 * points);
+
+    // Red points inside a circle, blue points around it
+    for (int i = 0; i < points; ++i) {
+        float x = dis(gen);
+        float y = dis(gen);
+        float dx = x - 0.5f;
+        float dy = y - 0.5f;
+        int color = (dx * dx + dy * dy < 0.3f * 0.3f) ? 0 : 1;
+
+        positions[2 * i] = x;
+        positions[2 * i + 1] = y;
+        classes[2 * i + color] = 1.0f;
+    }
+
+    inputs = af::array(2, points, positions.data());
+    targets = af::array(2, points, classes.data());
+}
+
+std::vector<Benchmark::Scenario> Benchmark::scalingSweep(std::vector<int> const &networks, std::vector<int> const &points,
+                                                         int generations, unsigned int seed) {
+    std::vector<Scenario> scenarios;
+    for (int n : networks) {
+        for (int p : points) {
+            scenarios.push_back({n, p, generations, seed});
+        }
+    }
+    return scenarios;
+}
+
+size_t Benchmark::deviceBytes() {
+    size_t allocBytes, allocBuffers, lockBytes, lockBuffers;
+    af::deviceMemInfo(&allocBytes, &allocBuffers, &lockBytes, &lockBuffers);
+    return allocBytes;
+}
+
+void Benchmark::generation(NeuralNetwork &network, af::array &inputs, af::array &targets, int winners) {
+    // Evaluate the population, select the winners and breed the next population
+    af::array fitness = -network.error(inputs, targets);
+    network.breed(fitness, winners, -_mutation, +_mutation);
+    af::sync();
+}
+
+Baseline::Measurement Benchmark::measure(std::string name, int runs, std::function<void()> const &function) {
+    Baseline::Measurement measurement;
+    measurement.name = std::move(name);
+
+    // The first run compiles the kernels and is not measured
+    function();
+    af::sync();
+
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        af::sync();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        measurement.samples.push_back(std::chrono::duration<float>(end - start).count());
+    }
+
+    measurement.peakDeviceBytes = deviceBytes();
+    return measurement;
+}
+
+std::vector<Baseline::Measurement> Benchmark::gate(int runs, unsigned int seed) {
+    std::vector<Baseline::Measurement> measurements;
+
+    // feed_forward of 1000 networks on 1000 samples
+    {
+        af::deviceGC();
+        af::setSeed(seed);
+        NeuralNetwork network(_topology, _activations, -2.8f, 2.8f, true, 1000);
+
+        af::array inputs, targets;
+        createDataset(1000, seed, inputs, targets);
+        af::array in = af::tile(inputs, 1, 1, network.networks());
+
+        measurements.push_back(measure("feed_forward", runs, [&]() {
+            af::array result = network.feed_forward(in);
+            result.eval();
+        }));
+    }
+
+    // breed of 10000 networks with a fixed fitness
+    {
+        af::deviceGC();
+        af::setSeed(seed);
+        NeuralNetwork network(_topology, _activations, -2.8f, 2.8f, true, 10000);
+        network.seed(seed);
+
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dis(-1.0f, 0.0f);
+        std::vector<float> fitness(network.networks());
+        for (auto &value : fitness) {
+            value = dis(gen);
+        }
+
+        int winners = std::max(1, (int)((float)network.networks() * _winnerRatio));
+        measurements.push_back(measure("breed", runs, [&]() {
+            network.breed(fitness, winners, -_mutation, +_mutation);
+        }));
+    }
+
+    // A whole generation of 1000 networks on 100 points
+    {
+        af::deviceGC();
+        af::setSeed(seed);
+        NeuralNetwork network(_topology, _activations, -2.8f, 2.8f, true, 1000);
+        network.seed(seed);
+
+        af::array inputs, targets;
+        createDataset(100, seed, inputs, targets);
+
+        int winners = std::max(1, (int)((float)network.networks() * _winnerRatio));
+        measurements.push_back(measure("generation", runs, [&]() {
+            generation(network, inputs, targets, winners);
+        }));
+    }
+
+    return measurements;
+}
+
+Benchmark::Result Benchmark::run(Scenario const &scenario) {
+    Result result;
+    result.scenario = scenario;
+
+    try {
+        // Start every scenario with an empty memory pool so the peak belongs to this scenario alone
+        af::deviceGC();
+        af::setSeed(scenario.seed);
+
+        NeuralNetwork network(_topology, _activations, -2.8f, 2.8f, true, scenario.networks);
+        network.seed(scenario.seed);
+
+        af::array inputs, targets;
+        createDataset(scenario.points, scenario.seed, inputs, targets);
+
+        int winners = std::max(1, (int)((float)scenario.networks * _winnerRatio));
+
+        // The first generation compiles the kernels and is not measured
+        generation(network, inputs, targets, winners);
+
+        for (int i = 0; i < scenario.generations; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            generation(network, inputs, targets, winners);
+            auto end = std::chrono::high_resolution_clock::now();
+
+            result.generationTimes.push_back(std::chrono::duration<float>(end - start).count());
+
+            // Freed buffers stay in ArrayFire's memory pool, so the allocated size is the high-water mark
+            result.peakDeviceBytes = std::max(result.peakDeviceBytes, deviceBytes());
+        }
+    } catch (const af::exception &e) {
+        std::cerr << "Scenario with " << scenario.networks << " networks and " << scenario.points
+                  << " points failed: " << e.what() << "\n";
+        result.failed = true;
+        af::deviceGC();
+        return result;
+    }
+
+    float total = 0.0f;
+    for (float time : result.generationTimes) {
+        total += time;
+    }
+
+    if (total > 0.0f) {
+        result.generationsPerSecond = (float)result.generationTimes.size() / total;
+        result.sampleEvaluationsPerSecond = (double)result.generationsPerSecond * scenario.networks * scenario.points;
+    }
+
+    return result;
+}
+
+void Benchmark::print(Result const &result) {
+    std::cout << std::setw(10) << result.scenario.networks << " networks "
+              << std::setw(8) << result.scenario.points << " points: ";
+
+    if (result.failed) {
+        std::cout << "failed\n";
+        return;
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+              << std::setw(10) << result.generationsPerSecond << " generations/s "
+              << std::scientific << std::setprecision(3)
+              << std::setw(12) << result.sampleEvaluationsPerSecond << " sample-evals/s "
+              << "peak " << Utility::sizeToString(result.peakDeviceBytes) << "\n"
+              << std::defaultfloat;
+}
+
+bool Benchmark::save(std::string path, std::vector<Result> const &results) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << path << "\n";
+        return false;
+    }
+
+    // One row per point of the scaling curve
+    file << "device,networks,points,generations,generations_per_second,sample_evaluations_per_second,peak_device_bytes\n";
+    for (auto &result : results) {
+        file << Utility::deviceName() << ","
+             << result.scenario.networks << ","
+             << result.scenario.points << ","
+             << result.generationTimes.size() << ","
+             << result.generationsPerSecond << ","
+             << result.sampleEvaluationsPerSecond << ","
+             << result.peakDeviceBytes << "\n";
+    }
+
+    file.close();
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef KI_BENCHMARK_H
+#define KI_BENCHMARK_H
+
+#include <arrayfire.h>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+
+#include "../NeuralNetwork/NeuralNetwork.h"
+#include "../Utility/Utility.h"
+#include "Baseline.h"
+
+class Benchmark {
+public:
+    // One point of the scaling curve
+    struct Scenario {
+        int networks;
+        int points;
+        int generations;
+        unsigned int seed;
+    };
+
+    struct Result {
+        Scenario scenario;
+        bool failed = false;
+        std::vector<float> generationTimes; // Seconds per generation
+        float generationsPerSecond = 0.0f;
+        double sampleEvaluationsPerSecond = 0.0;
+        size_t peakDeviceBytes = 0;
+    };
+
+private:
+    std::vector<int> _topology;
+    std::vector<Utility::Activations> _activations;
+
+    float _mutation = 0.05f;      // Same mutation range as the DrawingApp
+    float _winnerRatio = 0.01f;   // 500 out of 50000 networks in the DrawingApp
+
+    static size_t deviceBytes();
+
+    void generation(NeuralNetwork &network, af::array &inputs, af::array &targets, int winners);
+    static Baseline::Measurement measure(std::string name, int runs, std::function<void()> const &function);
+
+public:
+    Benchmark(std::vector<int> topology, std::vector<Utility::Activations> activations);
+
+    // Two classes of points in the unit square, like the ones drawn in the DrawingApp
+    static void createDataset(int points, unsigned int seed, af::array &inputs, af::array &targets);
+    static std::vector<Scenario> scalingSweep(std::vector<int> const &networks, std::vector<int> const &points,
+                                              int generations, unsigned int seed);
+
+    Result run(Scenario const &scenario);
+
+    // Small feed_forward, breed and generation benchmarks that also run quickly on the CPU backend
+    std::vector<Baseline::Measurement> gate(int runs, unsigned int seed);
+
+    static void print(Result const &result);
+    static bool save(std::string path, std::vector<Result> const &results);
+};
+
+
+#endif //KI_BENCHMARK_H
@@ -5,81 +5,79 @@
 #include "DrawingApp.h"
 int enumSize = 2;
 
-DrawingApp::DrawingApp(sf::Vector2i size, std::string title, NeuralNetwork &network) :
-sf::RenderWindow(sf::VideoMode(size.x, size.y), title), _network(network) {
-    // Load the font
-    if (!_globalFont.loadFromFile("../../resources/fonts/Roboto.ttf")) {
-        return;
-    }
-
+DrawingApp::DrawingApp(sf::Vector2i size, std::string title, TrainingWorker &worker) :
+sf::RenderWindow(sf::VideoMode(size.x, size.y), title), _worker(worker) {
     _previousSize = size;
-    _gridSize = (size.x > size.y) ? size.y : size.x;
 
-    int totalPoints = _gridSize * _gridSize;
+    // The unit square initially fills the smaller side of the window
+    _scale = (float)std::min(size.x, size.y) - 1.0f;
 
-    // Prepare vectors to hold all positions
-    std::vector<float> x_positions(totalPoints);
-    std::vector<float> y_positions(totalPoints);
-
-    // Generate coordinate pairs in row-major order
-    for (int index = 0; index < totalPoints; ++index) {
-        int x = index % _gridSize;
-        int y = index / _gridSize;
-        x_positions[index] = static_cast<float>(x) / (_gridSize - 1); // Normalize to [0,1]
-        y_positions[index] = static_cast<float>(y) / (_gridSize - 1); // Normalize to [0,1]
+    // Pack the color of every class as RGBA, so the tiles are colored on the device
+    std::vector<unsigned int> palette(enumSize);
+    for (int i = 0; i < enumSize; ++i) {
+        Point point;
+        point.color = static_cast<Color>(i);
+        sf::Color col = point.getColor();
+        palette[i] = col.r | (col.g << 8) | (col.b << 16) | ((unsigned int)col.a << 24);
     }
+    _palette = af::array(enumSize, palette.data());
+}
 
-    int numBatches = (totalPoints + _batchSize - 1) / _batchSize; // Ceiling division
-    for (int batch = 0; batch < numBatches; ++batch) {
-        int startIdx = batch * _batchSize;
-        int endIdx = std::min(startIdx + _batchSize, totalPoints);
-        int currentBatchSize = endIdx - startIdx;
-
-        std::vector<float> positionsVector(2 * currentBatchSize); // x and y positions
-        for (int i = 0; i < currentBatchSize; ++i) {
-            positionsVector[2 * i] = x_positions[startIdx + i];
-            positionsVector[2 * i + 1] = y_positions[startIdx + i];
-        }
-
-        // Convert to ArrayFire array
-        af::array in(2, 1, currentBatchSize, positionsVector.data());
-        _positions.emplace_back(in);
+DrawingApp::~DrawingApp() {
+    if (_pixels != nullptr) {
+        af::freePinned(_pixels);
     }
 }
 
 void DrawingApp::update() {
-    int totalPoints = _points.size();
-    int networks = _network.networks();
-
-    // Train the network on the placed points
-    if(totalPoints > 0){
-        std::vector<float> fitness(networks, 0.0f);
+    // Hand the placed points over to the training thread. As long as points were only added or replaced, just those
+    // are sent, otherwise the whole training set is replaced.
+    if (_pointsChanged) {
+        const std::vector<Point> &points = _points.points();
+        bool appended = _points.revision() == _submittedRevision && points.size() >= _submittedPoints;
+
+        if (appended) {
+            // Points the training already has are overwritten at their index, newer ones are part of the appended
+            std::vector<size_t> indices;
+            Dataset replaced(2, enumSize);
+            for (size_t i = _submittedReplaced; i < _points.replaced().size(); ++i) {
+                size_t index = _points.replaced()[i];
+                if (index < _submittedPoints) {
+                    indices.push_back(index);
+                    replaced.add({points[index].position.x, points[index].position.y}, points[index].color);
+                }
+            }
+            if (!indices.empty()) {
+                _worker.replace(std::move(indices), std::move(replaced));
+            }
+        }
 
-        for (auto &point : _points) {
+        Dataset dataset(2, enumSize);
+        for (size_t i = appended ? _submittedPoints : 0; i < points.size(); ++i) {
+            dataset.add({points[i].position.x, points[i].position.y}, points[i].color);
+        }
 
-            std::vector<float> pos = {
-                    point.position.x / ((float)_gridSize - 1.0f),
-                    point.position.y / ((float)_gridSize - 1.0f)
-            };
-            af::array in = Utility::vectorToArray(pos);
-            af::array in3d = af::tile(in, 1, 1, networks);
+        if (appended) {
+            _worker.append(std::move(dataset));
+        } else {
+            _worker.submit(std::move(dataset));
+        }
 
-            af::array result3d = _network.feed_forward(in3d);
+        _submittedPoints = points.size();
+        _submittedRevision = _points.revision();
+        _submittedReplaced = _points.replaced().size();
+        _pointsChanged = false;
+    }
 
-            af::array exp = Utility::mapIndexToArray(point.color, enumSize);
-            af::array exp3d = af::tile(exp, 1, 1, networks);
+    // Report every finished generation
+    auto snapshot = _worker.snapshot();
+    if (snapshot->version != _snapshotVersion) {
+        _snapshotVersion = snapshot->version;
 
-            af::array error = af::pow(result3d - exp3d, 2);
-            af::array error_per_network = af::sum(error, /*dim=*/0);
-            auto res = Utility::arrayToVector(af::flat(error_per_network));
-            for (int j = 0; j < res.size(); ++j) {
-                fitness[j] += -1.0f * res[j];
-            }
+        if (snapshot->statistics.generation > 0) {
+            std::cout << "The best performing network is #" << snapshot->statistics.best << " with an error of: "
+                      << snapshot->statistics.bestError << "\n";
         }
-
-        int idxBest = Utility::find_top_n(fitness, 1)[0];
-        std::cout << "The best performing network is #" << idxBest << " with an error of: " << -1.0f * fitness[idxBest] << "\n";
-        _network.breed(fitness, 500, -0.05f, +0.05f);
     }
 
     sf::Event event;
@@ -91,99 +89,467 @@ void DrawingApp::update() {
 
 
 void DrawingApp::render(bool showHUD) {
-    sf::Vector2u size = this->getSize();
-    sf::Vector2f leftUpperCorner((float)size.x / 2.0f - (float)_gridSize / 2.0f, (float)size.y / 2.0f - (float)_gridSize / 2.0f);
-
     this->clear(sf::Color::Black);
 
-    sf::RectangleShape rect;
-    rect.setSize({(float)_gridSize, (float)_gridSize});
-    rect.setFillColor({40, 40, 40});
-    rect.setPosition(leftUpperCorner);
+    renderNetworkOutput();
 
+    // Outline of the unit square the points are placed in
+    sf::RectangleShape rect;
+    rect.setSize({_scale, _scale});
+    rect.setFillColor(sf::Color::Transparent);
+    rect.setOutlineThickness(1);
+    rect.setOutlineColor({40, 40, 40});
+    rect.setPosition(toScreen({0.0f, 0.0f}));
     this->draw(rect);
 
-    renderNetworkOutput();
     renderPoints();
 
     this->display();
 }
 
 void DrawingApp::renderPoints() {
-    // Draw Poins
-    if (!_points.empty()) {
-        sf::CircleShape c;
-        c.setRadius(4);
-        c.setOutlineThickness(2);
-        c.setOutlineColor(sf::Color::Black);
-        for (auto &point : _points) {
-            c.setFillColor(point.getColor());
-            c.setPosition(point.position);
-            this->draw(c);
+    // The mesh is built for the power of two zoom level closest to the scale and stretched in between, so the circles
+    // stay about the same size in pixels while only a change of the level starts over, like removed points do
+    float level = _baseScale * std::exp2(std::round(std::log2(_scale / _baseScale)));
+    if (_meshRevision != _points.revision() || _meshScale != level) {
+        _pointVertices.clear();
+        _meshPoints = 0;
+        _uploadedVertices = 0;
+        _meshScale = level;
+        _meshAnchor = _viewCenter;
+        _meshRevision = _points.revision();
+        _meshReplaced = _points.replaced().size();
+    }
+
+    // Replaced points keep their slot, so only their vertices are rewritten
+    bool buffered = sf::VertexBuffer::isAvailable();
+    for (; _meshReplaced < _points.replaced().size(); ++_meshReplaced) {
+        size_t index = _points.replaced()[_meshReplaced];
+        if (index >= _meshPoints) {
+            continue;
+        }
+
+        size_t first = index * _pointVertexCount;
+        writePointMesh(_points.points()[index], _pointVertices.data() + first);
+        if (buffered && first + _pointVertexCount <= _uploadedVertices) {
+            _pointBuffer.update(_pointVertices.data() + first, _pointVertexCount, first);
         }
     }
+
+    // Only the points added since the last frame are tessellated
+    for (; _meshPoints < _points.size(); ++_meshPoints) {
+        appendPointMesh(_points.points()[_meshPoints]);
+    }
+
+    if (_pointVertices.empty()) {
+        return;
+    }
+
+    sf::RenderStates states;
+    states.transform.translate(toScreen(_meshAnchor));
+    states.transform.scale(_scale / _meshScale, _scale / _meshScale);
+
+    // Draw all points with one call
+    if (buffered) {
+        // Grow the buffer geometrically, then only the appended vertices have to be copied
+        if (_pointVertices.size() > _pointCapacity) {
+            _pointCapacity = std::max(_pointVertices.size(), 2 * _pointCapacity);
+            _pointBuffer.create(_pointCapacity);
+            _uploadedVertices = 0;
+        }
+        if (_uploadedVertices < _pointVertices.size()) {
+            _pointBuffer.update(_pointVertices.data() + _uploadedVertices, _pointVertices.size() - _uploadedVertices,
+                                _uploadedVertices);
+            _uploadedVertices = _pointVertices.size();
+        }
+
+        this->draw(_pointBuffer, 0, _pointVertices.size(), states);
+    } else {
+        this->draw(_pointVertices.data(), _pointVertices.size(), sf::Triangles, states);
+    }
+}
+
+void DrawingApp::appendPointMesh(const Point &point) {
+    size_t first = _pointVertices.size();
+    _pointVertices.resize(first + _pointVertexCount);
+    writePointMesh(point, _pointVertices.data() + first);
+}
+
+void DrawingApp::writePointMesh(const Point &point, sf::Vertex *vertices) const {
+    const float pi = 3.14159265f;
+    sf::Vector2f center((point.position.x - _meshAnchor.x) * _meshScale, (point.position.y - _meshAnchor.y) * _meshScale);
+
+    // A black disc for the outline, covered by a smaller one in the color of the point
+    for (auto [radius, color] : {std::make_pair(_pointRadius + _pointOutline, sf::Color::Black),
+                                 std::make_pair(_pointRadius, point.getColor())}) {
+        for (int segment = 0; segment < _pointSegments; ++segment) {
+            float a0 = 2.0f * pi * (float)segment / _pointSegments;
+            float a1 = 2.0f * pi * (float)(segment + 1) / _pointSegments;
+
+            *vertices++ = sf::Vertex(center, color);
+            *vertices++ = sf::Vertex(center + sf::Vector2f(std::cos(a0), std::sin(a0)) * radius, color);
+            *vertices++ = sf::Vertex(center + sf::Vector2f(std::cos(a1), std::sin(a1)) * radius, color);
+        }
+    }
+}
+
+bool DrawingApp::mapOutdated(const NeuralNetwork &champion) {
+    // Parameters can only have changed if the network was bred or loaded since
+    if (_mapValid && champion.version() == _mapVersion) {
+        return false;
+    }
+    _mapVersion = champion.version();
+
+    // The elite survives breeding unchanged, so compare the actual parameters
+    std::vector<float> parameters = champion.parameters(0);
+    if (_mapValid && parameters == _mapParameters) {
+        return false;
+    }
+    _mapParameters = std::move(parameters);
+    _mapValid = true;
+
+    return true;
 }
 
 void DrawingApp::renderNetworkOutput() {
-    // Total number of points
-    int totalPoints = _gridSize * _gridSize;
+    // Render the best network of the latest generation
+    auto snapshot = _worker.snapshot();
+
+    // Tiles of an older network start over with their coarse grid once they are visible again
+    if (mapOutdated(snapshot->champion)) {
+        _mapEpoch++;
+    }
+    _frame++;
+
+    // Tiles of the level closest to the current zoom, covering the window
+    int level = tileLevel();
+    float pixelsPerUnit = std::ldexp(_baseScale, level);
+    float tileUnits = (float)_tileSize / pixelsPerUnit;
+
+    sf::Vector2u size = this->getSize();
+    sf::Vector2f topLeft = toInput({0.0f, 0.0f});
+    sf::Vector2f bottomRight = toInput({(float)size.x, (float)size.y});
+
+    std::vector<Tile *> visible;
+    for (int y = (int)std::floor(topLeft.y / tileUnits); y <= (int)std::floor(bottomRight.y / tileUnits); ++y) {
+        for (int x = (int)std::floor(topLeft.x / tileUnits); x <= (int)std::floor(bottomRight.x / tileUnits); ++x) {
+            visible.push_back(&tile(level, x, y));
+        }
+    }
+    evictTiles();
+
+    // Sharpen the tiles in the centre of the window first
+    auto distance = [&](const Tile *tile) {
+        float dx = ((float)tile->x + 0.5f) * tileUnits - _viewCenter.x;
+        float dy = ((float)tile->y + 0.5f) * tileUnits - _viewCenter.y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(visible.begin(), visible.end(), [&](const Tile *a, const Tile *b) {
+        return distance(a) < distance(b);
+    });
+
+    // Refine towards the decision boundary as far as the budget of this frame allows
+    refineTiles(snapshot->champion, visible);
+
+    colorTiles(visible);
+
+    sf::Sprite sprite;
+    sprite.setScale(_scale / pixelsPerUnit, _scale / pixelsPerUnit);
+    for (Tile *tile : visible) {
+        sprite.setTexture(tile->texture, true);
+        sprite.setPosition(toScreen({(float)tile->x * tileUnits, (float)tile->y * tileUnits}));
+        this->draw(sprite);
+    }
+}
+
+int DrawingApp::tileLevel() const {
+    // Tiles of the closest level are at most scaled by a factor of sqrt(2) in either direction
+    return (int)std::lround(std::log2(_scale / _baseScale));
+}
+
+DrawingApp::Tile &DrawingApp::tile(int level, int x, int y) {
+    auto key = std::make_tuple(level, x, y);
+    auto it = _tileIndex.find(key);
+
+    if (it != _tileIndex.end()) {
+        // Move the tile to the front of the LRU list
+        _tiles.splice(_tiles.begin(), _tiles, it->second);
+    } else {
+        _tiles.emplace_front();
+        Tile &tile = _tiles.front();
+        tile.level = level;
+        tile.x = x;
+        tile.y = y;
+        tile.classes.assign(_tileSize * _tileSize, -1);
+        tile.colors.assign(_tileSize * _tileSize, 0);
+        tile.texture.create(_tileSize, _tileSize);
+        _tileIndex[key] = _tiles.begin();
+    }
+
+    _tiles.front().frame = _frame;
+    return _tiles.front();
+}
 
-    // Prepare vector to hold all colors
-    std::vector<int> colors(totalPoints);
+void DrawingApp::evictTiles() {
+    // Drop the least recently used tiles, but never one that is visible in this frame
+    while (_tiles.size() > _tileCapacity && _tiles.back().frame != _frame) {
+        Tile &tile = _tiles.back();
+        _tileIndex.erase(std::make_tuple(tile.level, tile.x, tile.y));
+        _tiles.pop_back();
+    }
+}
+
+void DrawingApp::resetTile(Tile &tile, std::vector<Request> &requests) {
+    std::fill(tile.classes.begin(), tile.classes.end(), -1);
+    tile.cells.clear();
+    tile.epoch = _mapEpoch;
+
+    // Request the corners of the coarse grid, the cells are filled and split during the refinement
+    for (int y = 0; y < _tileSize; y += _coarseCellSize) {
+        for (int x = 0; x < _tileSize; x += _coarseCellSize) {
+            Cell cell{x, y, _coarseCellSize};
+            requestCorners(tile, cell, requests);
+            tile.cells.push_back(cell);
+        }
+    }
+}
+
+void DrawingApp::refineTiles(const NeuralNetwork &champion, const std::vector<Tile *> &tiles) {
+    std::vector<Request> requests;
+    for (Tile *tile : tiles) {
+        if (tile->epoch != _mapEpoch) {
+            resetTile(*tile, requests);
+        }
+    }
+    evaluateRequests(champion, requests);
+    int evaluated = (int)requests.size();
+
+    bool pending = true;
+    while (pending && evaluated < _sampleBudget) {
+        requests.clear();
+        std::vector<std::pair<Tile *, Cell>> children;
+
+        // All queued cells have their corners evaluated, so they can be resolved until a batch is collected
+        for (Tile *tile : tiles) {
+            while (!tile->cells.empty() && evaluated + (int)requests.size() < _sampleBudget) {
+                Cell cell = tile->cells.front();
+                tile->cells.pop_front();
+
+                int right = std::min(cell.x + cell.size, _tileSize - 1);
+                int bottom = std::min(cell.y + cell.size, _tileSize - 1);
+                int8_t topLeft = tile->classes[cell.y * _tileSize + cell.x];
+                bool uniform = topLeft == tile->classes[cell.y * _tileSize + right] &&
+                               topLeft == tile->classes[bottom * _tileSize + cell.x] &&
+                               topLeft == tile->classes[bottom * _tileSize + right];
+
+                // Fill the whole cell, the children overwrite it once they are refined
+                fillCell(*tile, cell, topLeft);
+
+                if (uniform || cell.size == 1) {
+                    continue;
+                }
+
+                // The corners disagree, so the decision boundary passes through the cell
+                int half = cell.size / 2;
+                for (int dy = 0; dy < cell.size; dy += half) {
+                    for (int dx = 0; dx < cell.size; dx += half) {
+                        Cell child{cell.x + dx, cell.y + dy, half};
+                        requestCorners(*tile, child, requests);
+                        children.emplace_back(tile, child);
+                    }
+                }
+            }
+        }
+
+        evaluateRequests(champion, requests);
+        evaluated += (int)requests.size();
+
+        for (auto &[tile, child] : children) {
+            tile->cells.push_back(child);
+        }
+        pending = !children.empty();
+    }
+}
+
+void DrawingApp::requestCorners(Tile &tile, const Cell &cell, std::vector<Request> &requests) {
+    int right = std::min(cell.x + cell.size, _tileSize - 1);
+    int bottom = std::min(cell.y + cell.size, _tileSize - 1);
+
+    for (int y : {cell.y, bottom}) {
+        for (int x : {cell.x, right}) {
+            int index = y * _tileSize + x;
+            // Neighbouring cells share their corners, so every pixel is only requested once
+            if (tile.classes[index] == -1) {
+                tile.classes[index] = -2;
+                requests.push_back({&tile, index});
+            }
+        }
+    }
+}
+
+void DrawingApp::evaluateRequests(const NeuralNetwork &champion, const std::vector<Request> &requests) {
+    int totalPoints = (int)requests.size();
+    if (totalPoints == 0) {
+        return;
+    }
+
+    // Only the tile slot and the pixel within the tile are uploaded per request, the inputs are generated on the device
+    std::vector<const Tile *> tiles;
+    std::vector<uint16_t> slots(totalPoints);
+    std::vector<uint16_t> indices(totalPoints);
+    for (int i = 0; i < totalPoints; ++i) {
+        // Requests of the same tile are collected one after another
+        if (tiles.empty() || tiles.back() != requests[i].tile) {
+            tiles.push_back(requests[i].tile);
+        }
+        slots[i] = (uint16_t)(tiles.size() - 1);
+        indices[i] = (uint16_t)requests[i].index;
+    }
+
+    // Origin and pixel size of every tile, in double precision so deep zoom levels stay exact up to the float cast
+    std::vector<float> originsX(tiles.size());
+    std::vector<float> originsY(tiles.size());
+    std::vector<float> pixelUnits(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        double pixelsPerUnit = std::ldexp((double)_baseScale, tiles[i]->level);
+        originsX[i] = (float)((double)tiles[i]->x * _tileSize / pixelsPerUnit);
+        originsY[i] = (float)((double)tiles[i]->y * _tileSize / pixelsPerUnit);
+        pixelUnits[i] = (float)(1.0 / pixelsPerUnit);
+    }
+
+    dim_t tileCount = (dim_t)tiles.size();
+    af::array slot = af::array(totalPoints, slots.data()).as(u32);
+    af::array index = af::array(totalPoints, indices.data()).as(f32);
+    af::array originX = af::lookup(af::array(tileCount, originsX.data()), slot);
+    af::array originY = af::lookup(af::array(tileCount, originsY.data()), slot);
+    af::array unit = af::lookup(af::array(tileCount, pixelUnits.data()), slot);
+
+    // Column and row of every pixel within its tile
+    af::array row = af::floor(index / (float)_tileSize);
+    af::array column = index - row * (float)_tileSize;
+
+    // Inputs as [2, 1, totalPoints], the layout feed_forward_single expects
+    af::array x = originX + column * unit;
+    af::array y = originY + row * unit;
+    af::array positions = af::join(0, af::moddims(x, 1, 1, totalPoints), af::moddims(y, 1, 1, totalPoints));
 
     // Process inputs in batches
     int numBatches = (totalPoints + _batchSize - 1) / _batchSize; // Ceiling division
+    std::vector<uint8_t> classes(std::min(totalPoints, _batchSize));
 
     for (int batch = 0; batch < numBatches; ++batch) {
         int startIdx = batch * _batchSize;
-        int endIdx = std::min(startIdx + _batchSize, totalPoints);
-        int currentBatchSize = endIdx - startIdx;
+        int currentBatchSize = std::min(_batchSize, totalPoints - startIdx);
 
-        // Get the input array
-        af::array &in = _positions[batch];
+        af::array in = positions(af::span, af::span, af::seq(startIdx, startIdx + currentBatchSize - 1));
 
         // Feed forward the batch
-        af::array result = _network.feed_forward_single(in, 0); // Output shape: [n, 1, _batchSize]
+        af::array result = champion.feed_forward_single(in, 0); // Output shape: [n, 1, currentBatchSize]
 
-        // Reshape the result to [n, _batchSize] for easier processing
+        // Reshape the result to [n, currentBatchSize] for easier processing
         result = af::moddims(result, af::dim4(result.dims(0), result.dims(2)));
 
-        // Perform GPU-side operation to map results to color indices
-        af::array colorIndices = Utility::mapArrayToIndices(result);
+        // Only the class of every point is copied back, one byte each
+        af::array colorIndices = Utility::mapArrayToIndices(result).as(u8);
+        colorIndices.host(classes.data());
+
+        for (int i = 0; i < currentBatchSize; ++i) {
+            const Request &request = requests[startIdx + i];
+            request.tile->classes[request.index] = static_cast<int8_t>(classes[i]);
+        }
+    }
+}
 
-        // Retrieve the entire batch of colors in one call
-        std::vector<int> batchColors(colorIndices.elements());
-        colorIndices.host(batchColors.data());
+void DrawingApp::fillCell(Tile &tile, const Cell &cell, int8_t color) {
+    int right = std::min(cell.x + cell.size, _tileSize);
+    int bottom = std::min(cell.y + cell.size, _tileSize);
 
-        // Append the results to the main colors vector
-        colors.insert(colors.begin() + startIdx, batchColors.begin(), batchColors.end());
+    // Only the class byte is stored per pixel, the RGBA colors are looked up on the device
+    for (int y = cell.y; y < bottom; ++y) {
+        std::fill(tile.colors.begin() + y * _tileSize + cell.x, tile.colors.begin() + y * _tileSize + right,
+                  (uint8_t)color);
     }
+    tile.dirty = true;
+}
 
-    // Create an sf::Image to hold the pixel data
-    sf::Image image;
-    image.create(_gridSize, _gridSize);
+void DrawingApp::colorTiles(const std::vector<Tile *> &tiles) {
+    std::vector<Tile *> dirty;
+    for (Tile *tile : tiles) {
+        if (tile->dirty) {
+            dirty.push_back(tile);
+        }
+    }
+    if (dirty.empty()) {
+        return;
+    }
 
-    // Fill the image with the colors
-    for (int index = 0; index < totalPoints; ++index) {
-        int x = index % _gridSize;
-        int y = index / _gridSize;
+    // The classes of all refined tiles are uploaded at once and mapped to packed RGBA through the palette
+    size_t pixels = (size_t)_tileSize * _tileSize;
+    std::vector<uint8_t> classes(pixels * dirty.size());
+    for (size_t i = 0; i < dirty.size(); ++i) {
+        std::copy(dirty[i]->colors.begin(), dirty[i]->colors.end(), classes.begin() + (long)(i * pixels));
+    }
+    af::array colors = af::lookup(_palette, af::array((dim_t)classes.size(), classes.data()).as(u32));
 
-        Point point;
-        point.color = static_cast<Color>(colors[index]);
-        sf::Color col = point.getColor();
+    // The pinned buffer only grows, so it is reallocated at most a few times
+    if (dirty.size() > _pixelTiles) {
+        if (_pixels != nullptr) {
+            af::freePinned(_pixels);
+        }
+        _pixelTiles = dirty.size();
+        _pixels = static_cast<uint32_t *>(af::pinned(pixels * _pixelTiles, u32));
+    }
 
-        image.setPixel(x, y, col);
+    // Retrieve the colors of all tiles in one call, directly into the pinned buffer
+    colors.host(_pixels);
+    for (size_t i = 0; i < dirty.size(); ++i) {
+        dirty[i]->texture.update(reinterpret_cast<const sf::Uint8 *>(_pixels + i * pixels));
+        dirty[i]->dirty = false;
     }
+}
+
+sf::Vector2f DrawingApp::toInput(sf::Vector2f pixel) const {
+    sf::Vector2u size = this->getSize();
+    return {_viewCenter.x + (pixel.x - (float)size.x / 2.0f) / _scale,
+            _viewCenter.y + (pixel.y - (float)size.y / 2.0f) / _scale};
+}
+
+sf::Vector2f DrawingApp::toScreen(sf::Vector2f input) const {
+    sf::Vector2u size = this->getSize();
+    return {(input.x - _viewCenter.x) * _scale + (float)size.x / 2.0f,
+            (input.y - _viewCenter.y) * _scale + (float)size.y / 2.0f};
+}
+
+void DrawingApp::zoom(float factor, sf::Vector2i pixel) {
+    // Keep the input below the given pixel in place
+    sf::Vector2f before = toInput(sf::Vector2f(pixel));
+    _scale = std::clamp(_scale * factor, _minScale, _maxScale);
+    sf::Vector2f after = toInput(sf::Vector2f(pixel));
 
-    sf::Texture texture;
-    texture.loadFromImage(image);
-    sf::Sprite sprite(texture);
-    this->draw(sprite);
+    _viewCenter.x += before.x - after.x;
+    _viewCenter.y += before.y - after.y;
 }
 
+void DrawingApp::paint(sf::Vector2i pixel) {
+    sf::Vector2f input = toInput(sf::Vector2f(pixel));
+
+    // Shift turns the brush into an eraser
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift)) {
+        if (_points.erase(input, _brushRadius / _scale) > 0) {
+            _pointsChanged = true;
+        }
+    } else if (_points.add(Point(input, _currentDrawingColor))) {
+        _pointsChanged = true;
+    }
+}
 
 void DrawingApp::handleEvents(sf::Event event) {
+    const float moveSpeed = 20.0f;  // Pixels for moving the view with arrow keys
+    const float zoomSpeed = 0.1f;   // Zoom factor for keys and mouse wheel
+
     sf::Vector2i mousePos = sf::Mouse::getPosition(*this);
+    sf::Vector2u size = this->getSize();
+    sf::Vector2i windowCenter((int)size.x / 2, (int)size.y / 2);
 
     switch (event.type) {
         case sf::Event::Closed:
@@ -191,45 +557,72 @@ void DrawingApp::handleEvents(sf::Event event) {
             break;
 
         case sf::Event::Resized:
-        {
-            sf::View currView = this->getView();
-
-            sf::Vector2i diff = {(int) event.size.width - _previousSize.x, (int) event.size.height - _previousSize.y};
+            // Window pixels are used as coordinates, the input in the centre stays in place
             _previousSize = {(int) event.size.width, (int) event.size.height};
-
-            currView.move(diff.x / 2, diff.y / 2);
-            currView.setSize(event.size.width, event.size.height);
-            this->setView(currView);
+            this->setView(sf::View(sf::FloatRect(0, 0, (float)event.size.width, (float)event.size.height)));
             break;
-        }
 
         case sf::Event::KeyPressed:
             if(event.key.code == sf::Keyboard::C || event.key.code == sf::Keyboard::R){
                 _points.clear();
+                _pointsChanged = true;
+            } else if (event.key.code == sf::Keyboard::Down) {
+                _viewCenter.y += moveSpeed / _scale;
+            } else if (event.key.code == sf::Keyboard::Up) {
+                _viewCenter.y -= moveSpeed / _scale;
+            } else if (event.key.code == sf::Keyboard::Right) {
+                _viewCenter.x += moveSpeed / _scale;
+            } else if (event.key.code == sf::Keyboard::Left) {
+                _viewCenter.x -= moveSpeed / _scale;
+            } else if (event.key.code == sf::Keyboard::Equal) {
+                zoom(1.0f + zoomSpeed, windowCenter);  // Zoom in
+            } else if (event.key.code == sf::Keyboard::Dash) {
+                zoom(1.0f - zoomSpeed, windowCenter);  // Zoom out
+            } else if (event.key.code == sf::Keyboard::Num0) {
+                _viewCenter = {0.5f, 0.5f};            // Show the unit square again
+                _scale = (float)std::min(size.x, size.y) - 1.0f;
             }
+            break;
 
         case sf::Event::MouseButtonPressed:
             if (event.mouseButton.button == sf::Mouse::Left) {
-                _points.emplace_back(sf::Vector2f(mousePos.x, mousePos.y), _currentDrawingColor);
-            } else if (event.mouseButton.button == sf::Mouse::Right) {
-                _showResult = !_showResult;
+                paint(mousePos);
+            } else if (event.mouseButton.button == sf::Mouse::Middle) {
+                _dragging = true;
+                _prevMousePos = mousePos;
+            }
+            break;
+
+        case sf::Event::MouseButtonReleased:
+            if (event.mouseButton.button == sf::Mouse::Middle) {
+                _dragging = false;
             }
             break;
 
         case sf::Event::MouseMoved:
+            if (_dragging) {
+                _viewCenter.x += (float)(_prevMousePos.x - mousePos.x) / _scale;
+                _viewCenter.y += (float)(_prevMousePos.y - mousePos.y) / _scale;
+                _prevMousePos = mousePos;
+            }
             if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
-                _points.emplace_back(sf::Vector2f(mousePos.x, mousePos.y), _currentDrawingColor);
+                paint(mousePos);
             }
             break;
 
         case sf::Event::MouseWheelScrolled:
+            // Zoom towards the mouse while control is held, otherwise select the drawing color
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::LControl)) {
+                zoom(event.mouseWheelScroll.delta > 0 ? 1.0f + zoomSpeed : 1.0f - zoomSpeed, mousePos);
+            } else {
+                int selected = static_cast<int>(_currentDrawingColor) + event.mouseWheelScroll.delta;
+                selected = (selected >= enumSize) ? 0 : selected;
+                selected = (selected < 0) ? enumSize - 1 : selected;
+                _currentDrawingColor = static_cast<Color>(selected);
+            }
+            break;
 
-            int selected = static_cast<int>(_currentDrawingColor) + event.mouseWheelScroll.delta;
-            selected = (selected >= enumSize) ? 0 : selected;
-            selected = (selected < 0) ? enumSize - 1 : selected;
-            _currentDrawingColor = static_cast<Color>(selected);
-
+        default:
             break;
     }
 }
-
@@ -6,53 +6,130 @@
 #define KI_DRAWINGAPP_H
 
 #include "SFML/Graphics.hpp"
+#include <deque>
+#include <list>
+#include <map>
+#include <tuple>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
 #include "../../NeuralNetwork/NeuralNetwork.h"
-
-enum Color : int {Red = 0, Blue = 1};
-extern int enumSize;
-
-struct Point{
-    Color color;
-    sf::Vector2f position;
-
-    Point() = default;
-    Point(sf::Vector2f pos, Color col){
-        color = col;
-        position = pos;
-    }
-
-    sf::Color getColor(){
-        switch (color) {
-            case Red:
-                return sf::Color::Red;
-            case Blue:
-                return sf::Color::Blue;
-        }
-    }
-};
+#include "../../Training/TrainingWorker.h"
+#include "PointStore.h"
 
 class DrawingApp : public sf::RenderWindow {
 private:
-    sf::Font _globalFont;
     sf::Vector2i _previousSize;
 
     int _batchSize = 80000; // For rendering
-    NeuralNetwork &_network;
+    TrainingWorker &_worker;
+    uint64_t _snapshotVersion = 0;
+
+    // Nearby points are merged and at most _maxPoints are kept, so the training set stays small while drawing
+    PointStore _points{1.0f / 512.0f, _maxPoints};
+    bool _pointsChanged = false;
+    size_t _submittedPoints = 0;      // Points the training already has
+    uint64_t _submittedRevision = 0;  // Revision of the point store they were taken from
+    size_t _submittedReplaced = 0;    // Replacements of that revision the training already has
+    static constexpr size_t _maxPoints = 20000;
+    static constexpr float _brushRadius = 12.0f; // Pixels of the erase brush
+
+    // All points are drawn from one vertex buffer. New points are appended and replaced points only overwrite their
+    // own vertices. The mesh is only rebuilt after removals or when the zoom passes a power of two, since it is built
+    // relative to an anchor for a zoom level and panning and zooming within the level only transform it.
+    std::vector<sf::Vertex> _pointVertices;
+    sf::VertexBuffer _pointBuffer{sf::Triangles, sf::VertexBuffer::Dynamic};
+    size_t _pointCapacity = 0;      // Vertices the buffer was created with
+    size_t _uploadedVertices = 0;   // Vertices already copied into the buffer
+    size_t _meshPoints = 0;         // Points already in the mesh
+    uint64_t _meshRevision = 0;     // Revision of the point store the mesh was built for
+    size_t _meshReplaced = 0;       // Replacements of that revision already in the mesh
+    float _meshScale = 0.0f;        // Zoom level the mesh was built for, in pixels per input unit
+    sf::Vector2f _meshAnchor;       // Input at the origin of the mesh
+
+    static constexpr int _pointSegments = 10;
+    static constexpr float _pointRadius = 4.0f;
+    static constexpr float _pointOutline = 2.0f;
+    static constexpr size_t _pointVertexCount = 2 * 3 * _pointSegments; // Two discs of triangles per point
+    // Zoomable and pannable view of the input space
+    sf::Vector2f _viewCenter{0.5f, 0.5f}; // Input in the centre of the window
+    float _scale = _baseScale;             // Pixels per input unit
+    bool _dragging = false;
+    sf::Vector2i _prevMousePos;
+
+    static constexpr float _minScale = 16.0f;
+    static constexpr float _maxScale = 1.0e7f;
+
+    // Progressive decision map: the corners of a coarse grid are evaluated first, then only cells whose corners
+    // disagree on the class are split in a quadtree fashion, since only those contain the decision boundary
+    struct Cell {
+        int x;
+        int y;
+        int size;
+    };
+
+    // The map is cached in fixed-size tiles at discrete zoom levels, so panning and zooming reuse computed tiles
+    struct Tile {
+        int level;
+        int x;
+        int y;
+        uint64_t epoch = 0;             // Map epoch the tile was computed for
+        uint64_t frame = 0;             // Last frame the tile was visible
+        bool dirty = false;             // Pixels changed since the last texture update
+        std::deque<Cell> cells;         // Cells with evaluated corners waiting to be filled or split, coarse ones first
+        std::vector<int8_t> classes;    // Class of every pixel, -1 if not requested and -2 while it is evaluated
+        std::vector<uint8_t> colors;    // Class every pixel is drawn with, colored on the device
+        sf::Texture texture;
+    };
+    struct Request {
+        Tile *tile;
+        int index;
+    };
+    std::list<Tile> _tiles;         // Most recently used first
+    std::map<std::tuple<int, int, int>, std::list<Tile>::iterator> _tileIndex;
+    uint64_t _mapEpoch = 0;         // Increases whenever the rendered network changes
+    uint64_t _frame = 0;
+    af::array _palette;             // Packed RGBA color of every class
+    uint32_t *_pixels = nullptr;    // Pinned host memory for the colored tiles of a frame
+    size_t _pixelTiles = 0;         // Tiles that fit into _pixels
+
+    static constexpr int _tileSize = 128;
+    static constexpr float _baseScale = 256.0f;   // Pixels per input unit of the tiles at level 0
+    static constexpr size_t _tileCapacity = 384;
+    static constexpr int _coarseCellSize = 16;
+    static constexpr int _sampleBudget = 1 << 15; // Network evaluations per frame
+
+    // The map is only restarted if the rendered network changed
+    bool _mapValid = false;
+    uint64_t _mapVersion = 0;
+    std::vector<float> _mapParameters;
 
-    std::vector<Point> _points;
-    std::vector<af::array> _positions; // X and Y as float
-
-    bool _showResult = false;
     Color _currentDrawingColor = Red;
 
-    int _gridSize;
-
     void renderPoints();
+    void appendPointMesh(const Point &point);
+    void writePointMesh(const Point &point, sf::Vertex *vertices) const;
+    void paint(sf::Vector2i pixel);
     void renderNetworkOutput();
+    bool mapOutdated(const NeuralNetwork &champion);
+    int tileLevel() const;
+    Tile &tile(int level, int x, int y);
+    void evictTiles();
+    void resetTile(Tile &tile, std::vector<Request> &requests);
+    void refineTiles(const NeuralNetwork &champion, const std::vector<Tile *> &tiles);
+    void requestCorners(Tile &tile, const Cell &cell, std::vector<Request> &requests);
+    void evaluateRequests(const NeuralNetwork &champion, const std::vector<Request> &requests);
+    void fillCell(Tile &tile, const Cell &cell, int8_t color);
+    void colorTiles(const std::vector<Tile *> &tiles);
+
+    sf::Vector2f toInput(sf::Vector2f pixel) const;
+    sf::Vector2f toScreen(sf::Vector2f input) const;
+    void zoom(float factor, sf::Vector2i pixel);
     void handleEvents(sf::Event event);
 
 public:
-    DrawingApp(sf::Vector2i size, std::string title, NeuralNetwork &_network);
+    DrawingApp(sf::Vector2i size, std::string title, TrainingWorker &worker);
+    ~DrawingApp() override;
 
     void update();
     void render(bool showHUD = true);
@@ -0,0 +1,140 @@
+#include "PointStore.h"
+
+PointStore::PointStore(float epsilon, size_t capacity) : _epsilon(epsilon), _capacity(capacity) {
+}
+
+uint64_t PointStore::key(sf::Vector2f position) const {
+    return key((int64_t)std::floor(position.x / _epsilon), (int64_t)std::floor(position.y / _epsilon));
+}
+
+uint64_t PointStore::key(int64_t x, int64_t y) {
+    return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+}
+
+bool PointStore::add(const Point &point) {
+    uint64_t cell = key(point.position);
+
+    // A point in an occupied cell is merged: the same color is dropped, another color paints over it
+    auto it = _cells.find(cell);
+    if (it != _cells.end()) {
+        if (_points[it->second].color == point.color) {
+            return false;
+        }
+        replace(it->second, point, cell);
+        return true;
+    }
+
+    _seen++;
+    if (_capacity == 0 || _points.size() < _capacity) {
+        _cells[cell] = _points.size();
+        _points.push_back(point);
+        return true;
+    }
+
+    // The store is full: keep the new point with probability capacity / seen, in place of a random one
+    std::uniform_int_distribution<uint64_t> distribution(0, _seen - 1);
+    uint64_t slot = distribution(_generator);
+    if (slot >= _capacity) {
+        return false;
+    }
+
+    _cells.erase(key(_points[slot].position));
+    replace(slot, point, cell);
+    return true;
+}
+
+size_t PointStore::erase(sf::Vector2f center, float radius) {
+    std::vector<size_t> removed;
+
+    int64_t minX = (int64_t)std::floor((center.x - radius) / _epsilon);
+    int64_t maxX = (int64_t)std::floor((center.x + radius) / _epsilon);
+    int64_t minY = (int64_t)std::floor((center.y - radius) / _epsilon);
+    int64_t maxY = (int64_t)std::floor((center.y + radius) / _epsilon);
+
+    auto inside = [&](const Point &point) {
+        float dx = point.position.x - center.x;
+        float dy = point.position.y - center.y;
+        return dx * dx + dy * dy <= radius * radius;
+    };
+
+    // Visit the cells below the brush, or all points if that is cheaper for a large brush
+    if ((double)(maxX - minX + 1) * (double)(maxY - minY + 1) < (double)_points.size()) {
+        for (int64_t y = minY; y <= maxY; ++y) {
+            for (int64_t x = minX; x <= maxX; ++x) {
+                auto it = _cells.find(key(x, y));
+                if (it != _cells.end() && inside(_points[it->second])) {
+                    removed.push_back(it->second);
+                }
+            }
+        }
+    } else {
+        for (size_t i = 0; i < _points.size(); ++i) {
+            if (inside(_points[i])) {
+                removed.push_back(i);
+            }
+        }
+    }
+
+    // Remove from the back, so the swapped in points are never ones that still have to be removed
+    std::sort(removed.begin(), removed.end(), std::greater<>());
+    for (size_t index : removed) {
+        remove(index);
+    }
+
+    if (!removed.empty()) {
+        bump();
+    }
+    return removed.size();
+}
+
+void PointStore::clear() {
+    _points.clear();
+    _cells.clear();
+    _seen = 0;
+    bump();
+}
+
+void PointStore::capacity(size_t capacity) {
+    _capacity = capacity;
+
+    // Shrinking keeps a random subset
+    if (_capacity != 0 && _points.size() > _capacity) {
+        std::shuffle(_points.begin(), _points.end(), _generator);
+        _points.resize(_capacity);
+
+        _cells.clear();
+        for (size_t i = 0; i < _points.size(); ++i) {
+            _cells[key(_points[i].position)] = i;
+        }
+        bump();
+    }
+}
+
+void PointStore::replace(size_t index, const Point &point, uint64_t cell) {
+    _points[index] = point;
+    _cells[cell] = index;
+
+    // Once the log is longer than the store, readers are better off starting over
+    if (_replaced.size() >= std::max<size_t>(_points.size(), 1024)) {
+        bump();
+    } else {
+        _replaced.push_back(index);
+    }
+}
+
+void PointStore::bump() {
+    _revision++;
+    _replaced.clear();
+}
+
+void PointStore::remove(size_t index) {
+    _cells.erase(key(_points[index].position));
+
+    // Swap with the last point and fix its index
+    size_t last = _points.size() - 1;
+    if (index != last) {
+        _points[index] = _points[last];
+        _cells[key(_points[index].position)] = index;
+    }
+    _points.pop_back();
+}
@@ -0,0 +1,79 @@
+#ifndef KI_POINTSTORE_H
+#define KI_POINTSTORE_H
+
+#include "SFML/Graphics.hpp"
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+enum Color : int {Red = 0, Blue = 1};
+extern int enumSize;
+
+struct Point{
+    Color color;
+    sf::Vector2f position;
+
+    Point() = default;
+    Point(sf::Vector2f pos, Color col){
+        color = col;
+        position = pos;
+    }
+
+    sf::Color getColor() const {
+        switch (color) {
+            case Red:
+                return sf::Color::Red;
+            case Blue:
+                return sf::Color::Blue;
+        }
+    }
+};
+
+// Drawn points indexed by a spatial hash. Every cell of size epsilon holds at most one point, so dragging the mouse
+// over the same spot does not grow the training set. With a capacity the store keeps a uniform sample of all points
+// that were added (reservoir sampling).
+class PointStore {
+private:
+    float _epsilon;
+    size_t _capacity;   // 0 for no limit
+
+    std::vector<Point> _points;
+    std::unordered_map<uint64_t, size_t> _cells; // Cell key to the index of its point
+
+    uint64_t _seen = 0;     // Distinct points offered since the last clear
+    uint64_t _revision = 0; // Increases whenever points are removed, appending and replacing keeps it
+    std::vector<size_t> _replaced; // Indices of the points replaced in place since the revision changed
+    std::mt19937 _generator{std::random_device{}()};
+
+    [[nodiscard]] uint64_t key(sf::Vector2f position) const;
+    [[nodiscard]] static uint64_t key(int64_t x, int64_t y);
+    void replace(size_t index, const Point &point, uint64_t cell);
+    void remove(size_t index);
+    void bump();
+
+public:
+    explicit PointStore(float epsilon = 1.0f / 512.0f, size_t capacity = 0);
+
+    // Returns true if the store changed
+    bool add(const Point &point);
+    // Removes all points within the radius and returns how many there were
+    size_t erase(sf::Vector2f center, float radius);
+    void clear();
+
+    void capacity(size_t capacity);
+
+    [[nodiscard]] const std::vector<Point> &points() const { return _points; }
+    [[nodiscard]] size_t size() const { return _points.size(); }
+    [[nodiscard]] bool empty() const { return _points.empty(); }
+    [[nodiscard]] uint64_t revision() const { return _revision; }
+    // Grows by one entry per replaced point, readers remember how many entries they have seen in a revision
+    [[nodiscard]] const std::vector<size_t> &replaced() const { return _replaced; }
+    [[nodiscard]] float epsilon() const { return _epsilon; }
+};
+
+
+#endif //KI_POINTSTORE_H
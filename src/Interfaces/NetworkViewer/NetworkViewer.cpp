@@ -11,8 +11,8 @@
 #undef min
 #endif
 
-NetworkViewer::NetworkViewer(sf::Vector2i size, std::string title, NeuralNetwork &network) :
-sf::RenderWindow(sf::VideoMode(size.x, size.y), title), _network(network) {
+NetworkViewer::NetworkViewer(sf::Vector2i size, std::string title, TrainingWorker &worker) :
+sf::RenderWindow(sf::VideoMode(size.x, size.y), title), _worker(worker) {
     // Set current time
     _currentTime = std::chrono::high_resolution_clock::now();
     _previousTime = _currentTime;
@@ -55,11 +55,16 @@ void NetworkViewer::render(bool showGUI) {
     if (showGUI) {
         renderHUD();  // Render the HUD with the fixed view
     }
+    if (_showDashboard) {
+        renderDashboard();
+    }
 
     this->display();
 }
 
 void NetworkViewer::renderHUD() {
+    auto snapshot = _worker.snapshot();
+
     sf::Text hudText;
     hudText.setFont(_globalFont);
     hudText.setCharacterSize(14);
@@ -74,8 +79,10 @@ void NetworkViewer::renderHUD() {
     hudInfo.push_back("Toolkit: " + std::string(Utility::toolkit()));
     hudInfo.push_back("Compute version: " + std::string(Utility::computeVersion()));
     hudInfo.push_back("Support for double operations(64 Bit): " + std::string(Utility::doubleSupport() ? "true" : "false"));
-    hudInfo.push_back("Number of Layers: " + std::to_string(_network.size()));
-    hudInfo.push_back("Memory info: (Occupied: " + Utility::sizeToString(_network.bytes()) + ")");
+    hudInfo.push_back("Number of Layers: " + std::to_string(snapshot->champion.size()));
+    hudInfo.push_back("Memory info: (Occupied: " + Utility::sizeToString(snapshot->bytes) + ")");
+    hudInfo.push_back("Generation: " + std::to_string(snapshot->statistics.generation));
+    hudInfo.push_back("Best error: " + std::to_string(snapshot->statistics.bestError));
 
     float padding = 6.0f;
     float yPos = 10.0f;
@@ -114,87 +121,378 @@ void NetworkViewer::renderHUD() {
     }
 }
 
-void NetworkViewer::renderNetwork() {
-    std::vector<int> topology = _network.topology();
-    auto &weights = _network.weights();
-    auto &biases = _network.biases();
-
-    const float minWeight = -1.0f, maxWeight = 1.0f;
-    const float minBias = -1.0f, maxBias = 1.0f;
+void NetworkViewer::renderDashboard() {
+    auto snapshot = _worker.snapshot();
+    if (!snapshot->hasSummary) {
+        return;
+    }
+    const Trainer::Summary &summary = snapshot->summary;
 
-    const float neuronRadius = 10.f;
-    const float layerSpacing = 75.0f;
-    const float neuronSpacing = 50.f;
+    const float padding = 6.0f;
+    const float histogramWidth = 320.0f;
+    const float histogramHeight = 100.0f;
+    const float cellSize = 4.0f;
 
-    const float outline = 2.5f;
+    sf::Vector2u size = this->getSize();
+    float left = padding;
+    float bottom = (float)size.y - padding;
 
-    // Cache weights and biases from ArrayFire once
-    std::vector<std::vector<std::vector<float>>> cachedWeights(topology.size() - 1); // 3D array for weights
-    std::vector<std::vector<float>> cachedBiases(topology.size() - 1); // 2D array for biases
+    // Fitness histogram over the error range of the last generation
+    float maxCount = 1.0f;
+    for (float count : summary.histogram) {
+        maxCount = std::max(maxCount, count);
+    }
 
-    for (size_t layer = 1; layer < topology.size(); ++layer) {
-        cachedWeights[layer - 1].resize(topology[layer]);
-        for (int neuron = 0; neuron < topology[layer]; ++neuron) {
-            cachedWeights[layer - 1][neuron].resize(topology[layer - 1]);
-            for (int prevNeuron = 0; prevNeuron < topology[layer - 1]; ++prevNeuron) {
-                cachedWeights[layer - 1][neuron][prevNeuron] = weights[layer - 1](neuron, prevNeuron).scalar<float>();
+    sf::RectangleShape background(sf::Vector2f(histogramWidth + 2 * padding, histogramHeight + 2 * padding));
+    background.setFillColor(sf::Color(0, 0, 0, 180));
+    background.setPosition(left - padding, bottom - histogramHeight - padding);
+    draw(background);
+
+    sf::VertexArray bars(sf::Triangles);
+    float barWidth = histogramWidth / (float)summary.histogram.size();
+    for (size_t i = 0; i < summary.histogram.size(); ++i) {
+        float height = summary.histogram[i] / maxCount * histogramHeight;
+        float x0 = left + (float)i * barWidth;
+        float x1 = x0 + barWidth - 1.0f;
+        sf::Color color = valueToColor(1.0f - (float)i / (float)summary.histogram.size(), 0.0f, 3.0f);
+
+        bars.append(sf::Vertex(sf::Vector2f(x0, bottom), color));
+        bars.append(sf::Vertex(sf::Vector2f(x1, bottom), color));
+        bars.append(sf::Vertex(sf::Vector2f(x1, bottom - height), color));
+        bars.append(sf::Vertex(sf::Vector2f(x0, bottom), color));
+        bars.append(sf::Vertex(sf::Vector2f(x1, bottom - height), color));
+        bars.append(sf::Vertex(sf::Vector2f(x0, bottom - height), color));
+    }
+    draw(bars);
+
+    // Mean (colour) and standard deviation (brightness) of every connection over the population
+    sf::VertexArray cells(sf::Triangles);
+    float x = left + histogramWidth + 3 * padding;
+    for (size_t layer = 0; layer < summary.shapes.size(); ++layer) {
+        int rows = summary.shapes[layer].first;
+        int cols = summary.shapes[layer].second;
+
+        for (int half = 0; half < 2; ++half) {
+            float top = bottom - (float)(2 - half) * (rows * cellSize + padding);
+
+            for (int col = 0; col < cols; ++col) {
+                for (int row = 0; row < rows; ++row) {
+                    size_t index = (size_t)col * rows + row;
+                    sf::Color color;
+                    if (half == 0) {
+                        color = valueToColor(summary.means[layer][index], -1.0f, 1.0f);
+                    } else {
+                        auto brightness = (sf::Uint8)(std::min(1.0f, summary.deviations[layer][index]) * 255.0f);
+                        color = sf::Color(brightness, brightness, brightness);
+                    }
+
+                    sf::Vector2f p(x + (float)col * cellSize, top + (float)row * cellSize);
+                    sf::Vector2f q = p + sf::Vector2f(cellSize, cellSize);
+                    cells.append(sf::Vertex(p, color));
+                    cells.append(sf::Vertex(sf::Vector2f(q.x, p.y), color));
+                    cells.append(sf::Vertex(q, color));
+                    cells.append(sf::Vertex(p, color));
+                    cells.append(sf::Vertex(q, color));
+                    cells.append(sf::Vertex(sf::Vector2f(p.x, q.y), color));
+                }
             }
         }
-        cachedBiases[layer - 1].resize(topology[layer]);
-        for (int neuron = 0; neuron < topology[layer]; ++neuron) {
-            cachedBiases[layer - 1][neuron] = biases[layer - 1](neuron).scalar<float>();
-        }
+        x += (float)cols * cellSize + padding;
+    }
+    draw(cells);
+
+    // Convergence indicators
+    std::vector<std::string> lines;
+    lines.push_back("Error range: " + std::to_string(summary.minError) + " - " + std::to_string(summary.maxError));
+    lines.push_back("Elite error: " + std::to_string(summary.eliteError));
+    lines.push_back("Diversity: " + std::to_string(summary.diversity));
+    lines.push_back("Elite diversity: " + std::to_string(summary.eliteDiversity) + " (" +
+                    std::to_string((int)(summary.eliteDiversity / std::max(summary.diversity, 1e-12f) * 100.0f)) + "%)");
+
+    sf::Text text;
+    text.setFont(_globalFont);
+    text.setCharacterSize(14);
+    text.setFillColor(sf::Color::White);
+
+    float y = bottom - histogramHeight - padding - (float)lines.size() * 20.0f;
+    for (auto &line : lines) {
+        text.setString(line);
+        sf::FloatRect bounds = text.getLocalBounds();
+        sf::RectangleShape textBackground(sf::Vector2f(bounds.width + 2 * padding, bounds.height + 2 * padding));
+        textBackground.setFillColor(sf::Color(0, 0, 0, 180));
+        textBackground.setPosition(0, y - padding / 2);
+        text.setPosition(padding, y);
+
+        draw(textBackground);
+        draw(text);
+        y += 20.0f;
     }
+}
 
-    // Vertex array for all lines (connections between neurons)
-    sf::VertexArray lines(sf::Lines);
+void NetworkViewer::renderNetwork() {
+    // Render the best network of the latest generation
+    auto snapshot = _worker.snapshot();
+    const NeuralNetwork &network = snapshot->champion;
+    _topology = network.topology();
+
+    // Single weights come from the host mirror, bundles are reduced on the device
+    int group = levelOfDetail();
+    bool parametersChanged = (group == 1) ? updateMirror(network) : updateGroups(network, group);
+
+    // Only the colours depend on the parameters, the positions only on the layout
+    if (layoutOutdated(group)) {
+        buildLayout(group);
+        updateColors();
+    } else if (parametersChanged) {
+        updateColors();
+    }
 
-    // Create circle shapes for neurons
-    std::vector<sf::CircleShape> neurons;
+    if (_neuronVertices.empty()) {
+        return;
+    }
 
-    for (size_t layer = 0; layer < topology.size(); ++layer) {
-        float x = (layer + 1) * layerSpacing;
-        float yOffset = (this->getSize().y - topology[layer] * neuronSpacing) / 2.0f;
+    // Draw all lines and all neurons with one call each
+    if (sf::VertexBuffer::isAvailable()) {
+        this->draw(_connectionBuffer);
+        this->draw(_neuronBuffer);
+    } else {
+        this->draw(_connectionVertices.data(), _connectionVertices.size(), sf::Lines);
+        this->draw(_neuronVertices.data(), _neuronVertices.size(), sf::Triangles);
+    }
+}
+
+int NetworkViewer::levelOfDetail() {
+    // Zoomed out views show more world units per pixel
+    float zoom = _networkView.getSize().y / (float)this->getSize().y;
+
+    int group = 1;
+    while (_neuronSpacing * (float)group / zoom < _minGroupSpacing) {
+        group *= 2;
+    }
+    return group;
+}
+
+sf::FloatRect NetworkViewer::visibleRegion() {
+    sf::Vector2f size = _networkView.getSize();
+    sf::Vector2f center = _networkView.getCenter();
+    return {center.x - size.x / 2.0f, center.y - size.y / 2.0f, size.x, size.y};
+}
+
+bool NetworkViewer::layoutOutdated(int group) {
+    if (_topology != _layoutTopology || this->getSize().y != _layoutHeight || group != _layoutGroup) {
+        return true;
+    }
 
-        // Collect connections between layers
+    // A culled layout has to be rebuilt once the view leaves the built region
+    if (_layoutCulled) {
+        sf::FloatRect visible = visibleRegion();
+        return !_layoutRegion.contains(visible.left, visible.top) ||
+               !_layoutRegion.contains(visible.left + visible.width, visible.top + visible.height);
+    }
+    return false;
+}
+
+void NetworkViewer::buildLayout(int group) {
+    _layoutTopology = _topology;
+    _layoutHeight = this->getSize().y;
+    _layoutGroup = group;
+
+    _connections.clear();
+    _neurons.clear();
+    _connectionVertices.clear();
+    _neuronVertices.clear();
+
+    // Number of drawn neurons per layer
+    std::vector<int> counts;
+    size_t totalConnections = 0;
+    for (size_t layer = 0; layer < _topology.size(); ++layer) {
+        counts.push_back((_topology[layer] + group - 1) / group);
         if (layer > 0) {
-            for (int prevNeuron = 0; prevNeuron < topology[layer - 1]; ++prevNeuron) {
-                float prevX = layer * layerSpacing;
-                float prevY = (this->getSize().y - topology[layer - 1] * neuronSpacing) / 2.0f + prevNeuron * neuronSpacing;
+            totalConnections += (size_t)counts[layer] * counts[layer - 1];
+        }
+    }
 
-                for (int currNeuron = 0; currNeuron < topology[layer]; ++currNeuron) {
-                    float currX = (layer + 1) * layerSpacing;
-                    float currY = (this->getSize().y - topology[layer] * neuronSpacing) / 2.0f + currNeuron * neuronSpacing;
+    // Large layouts are only built for the visible region plus a margin
+    _layoutCulled = totalConnections > _maxConnections;
+    sf::FloatRect visible = visibleRegion();
+    _layoutRegion = sf::FloatRect(visible.left - visible.width / 2.0f, visible.top - visible.height / 2.0f,
+                                  visible.width * 2.0f, visible.height * 2.0f);
 
-                    sf::Color lineColor = valueToColor(cachedWeights[layer - 1][currNeuron][prevNeuron], minWeight, maxWeight);
+    // Position of a neuron or of the centre of a group of neurons
+    auto position = [&](size_t layer, int index) {
+        int first = index * group;
+        int last = std::min(_topology[layer], first + group) - 1;
+        float yOffset = (_layoutHeight - _topology[layer] * _neuronSpacing) / 2.0f;
+        return sf::Vector2f((layer + 1) * _layerSpacing, yOffset + (float)(first + last) / 2.0f * _neuronSpacing);
+    };
 
-                    // Add the line to the vertex array
-                    lines.append(sf::Vertex(sf::Vector2f(prevX, prevY), lineColor));
-                    lines.append(sf::Vertex(sf::Vector2f(currX, currY), lineColor));
+    const float pi = 3.14159265f;
+
+    for (size_t layer = 0; layer < _topology.size(); ++layer) {
+        // Connections between layers, coloured later
+        if (layer > 0) {
+            for (int prevNeuron = 0; prevNeuron < counts[layer - 1]; ++prevNeuron) {
+                sf::Vector2f prev = position(layer - 1, prevNeuron);
+
+                for (int currNeuron = 0; currNeuron < counts[layer]; ++currNeuron) {
+                    sf::Vector2f curr = position(layer, currNeuron);
+
+                    if (_layoutCulled) {
+                        sf::FloatRect bounds(prev.x, std::min(prev.y, curr.y), curr.x - prev.x,
+                                             std::max(1.0f, std::abs(curr.y - prev.y)));
+                        if (!bounds.intersects(_layoutRegion)) {
+                            continue;
+                        }
+                    }
+
+                    _connections.push_back({(int)layer, currNeuron, prevNeuron});
+                    _connectionVertices.emplace_back(prev);
+                    _connectionVertices.emplace_back(curr);
                 }
             }
         }
 
-        // Collect neurons in the current layer as circles
-        for (int neuron = 0; neuron < topology[layer]; ++neuron) {
-            sf::CircleShape neuronShape(neuronRadius);
-            neuronShape.setPosition(x - neuronRadius, yOffset + neuron * neuronSpacing - neuronRadius);
-            neuronShape.setOutlineThickness(outline);
-            neuronShape.setOutlineColor((layer > 0) ? valueToColor(cachedBiases[layer - 1][neuron], minBias, maxBias) : sf::Color::White);
-            neuronShape.setFillColor(sf::Color::Black);
+        // Neurons as triangles: a black fill followed by the outline ring
+        for (int neuron = 0; neuron < counts[layer]; ++neuron) {
+            sf::Vector2f center = position(layer, neuron);
+
+            if (_layoutCulled && !_layoutRegion.contains(center)) {
+                continue;
+            }
+            _neurons.push_back({(int)layer, neuron});
 
-            // Store the neuron for later drawing
-            neurons.push_back(neuronShape);
+            for (int segment = 0; segment < _neuronSegments; ++segment) {
+                float a0 = 2.0f * pi * (float)segment / _neuronSegments;
+                float a1 = 2.0f * pi * (float)(segment + 1) / _neuronSegments;
+                sf::Vector2f d0(std::cos(a0), std::sin(a0));
+                sf::Vector2f d1(std::cos(a1), std::sin(a1));
+
+                _neuronVertices.emplace_back(center, sf::Color::Black);
+                _neuronVertices.emplace_back(center + d0 * _neuronRadius, sf::Color::Black);
+                _neuronVertices.emplace_back(center + d1 * _neuronRadius, sf::Color::Black);
+            }
+
+            for (int segment = 0; segment < _neuronSegments; ++segment) {
+                float a0 = 2.0f * pi * (float)segment / _neuronSegments;
+                float a1 = 2.0f * pi * (float)(segment + 1) / _neuronSegments;
+                sf::Vector2f d0(std::cos(a0), std::sin(a0));
+                sf::Vector2f d1(std::cos(a1), std::sin(a1));
+
+                sf::Vector2f inner0 = center + d0 * _neuronRadius;
+                sf::Vector2f inner1 = center + d1 * _neuronRadius;
+                sf::Vector2f outer0 = center + d0 * (_neuronRadius + _outline);
+                sf::Vector2f outer1 = center + d1 * (_neuronRadius + _outline);
+
+                _neuronVertices.emplace_back(inner0, sf::Color::White);
+                _neuronVertices.emplace_back(outer0, sf::Color::White);
+                _neuronVertices.emplace_back(outer1, sf::Color::White);
+                _neuronVertices.emplace_back(inner0, sf::Color::White);
+                _neuronVertices.emplace_back(outer1, sf::Color::White);
+                _neuronVertices.emplace_back(inner1, sf::Color::White);
+            }
+        }
+    }
+
+    if (sf::VertexBuffer::isAvailable()) {
+        _connectionBuffer.create(_connectionVertices.size());
+        _neuronBuffer.create(_neuronVertices.size());
+    }
+}
+
+void NetworkViewer::updateColors() {
+    const float minWeight = -1.0f, maxWeight = 1.0f;
+    const float minBias = -1.0f, maxBias = 1.0f;
+
+    for (size_t i = 0; i < _connections.size(); ++i) {
+        Connection &c = _connections[i];
+
+        float value;
+        if (_layoutGroup == 1) {
+            value = weight(c.layer - 1, c.neuron, c.prevNeuron);
+        } else {
+            int groups = (_topology[c.layer] + _layoutGroup - 1) / _layoutGroup;
+            value = _groupedWeights[c.layer - 1][(size_t)c.prevNeuron * groups + c.neuron];
+        }
+
+        sf::Color lineColor = valueToColor(value, minWeight, maxWeight);
+        _connectionVertices[2 * i].color = lineColor;
+        _connectionVertices[2 * i + 1].color = lineColor;
+    }
+
+    // Only the outline rings show the biases, the input layer stays white
+    const size_t verticesPerNeuron = 9 * _neuronSegments;
+    const size_t fillVertices = 3 * _neuronSegments;
+    for (size_t i = 0; i < _neurons.size(); ++i) {
+        Neuron &n = _neurons[i];
+        if (n.layer == 0) {
+            continue;
         }
+
+        float value = (_layoutGroup == 1) ? bias(n.layer - 1, n.neuron) : _groupedBiases[n.layer - 1][n.neuron];
+        sf::Color outlineColor = valueToColor(value, minBias, maxBias);
+
+        for (size_t v = fillVertices; v < verticesPerNeuron; ++v) {
+            _neuronVertices[i * verticesPerNeuron + v].color = outlineColor;
+        }
+    }
+
+    if (sf::VertexBuffer::isAvailable() && !_neuronVertices.empty()) {
+        _connectionBuffer.update(_connectionVertices.data());
+        _neuronBuffer.update(_neuronVertices.data());
+    }
+}
+
+bool NetworkViewer::updateMirror(const NeuralNetwork &network) {
+    if (_mirrorValid && network.version() == _mirrorVersion) {
+        return false;
+    }
+
+    // One transfer for all parameters instead of one per weight
+    _parameters = network.parameters(0);
+
+    // Every layer stores its weights (column-major) followed by its biases
+    _weightOffsets.clear();
+    _biasOffsets.clear();
+    size_t offset = 0;
+    for (size_t layer = 1; layer < _topology.size(); ++layer) {
+        _weightOffsets.push_back(offset);
+        offset += (size_t)_topology[layer] * _topology[layer - 1];
+        _biasOffsets.push_back(offset);
+        offset += _topology[layer];
     }
 
-    // Draw all lines with one call
-    this->draw(lines);
+    _mirrorVersion = network.version();
+    _mirrorValid = true;
+    return true;
+}
 
-    // Draw all neurons with one call
-    for (auto &neuron : neurons) {
-        this->draw(neuron);
+bool NetworkViewer::updateGroups(const NeuralNetwork &network, int group) {
+    if (_groupsValid && network.version() == _groupsVersion && group == _groupsSize && _absMaxBundles == _groupsAbsMax) {
+        return false;
     }
+
+    _groupedWeights.clear();
+    _groupedBiases.clear();
+    for (size_t layer = 0; layer < network.weights().size(); ++layer) {
+        _groupedWeights.push_back(Utility::arrayToVector(
+                Utility::blockReduce(network.weights()[layer], group, group, _absMaxBundles)));
+        _groupedBiases.push_back(Utility::arrayToVector(
+                Utility::blockReduce(network.biases()[layer], group, 1, _absMaxBundles)));
+    }
+
+    _groupsVersion = network.version();
+    _groupsSize = group;
+    _groupsAbsMax = _absMaxBundles;
+    _groupsValid = true;
+    return true;
+}
+
+float NetworkViewer::weight(size_t layer, int neuron, int prevNeuron) const {
+    return _parameters[_weightOffsets[layer] + (size_t)prevNeuron * _topology[layer + 1] + neuron];
+}
+
+float NetworkViewer::bias(size_t layer, int neuron) const {
+    return _parameters[_biasOffsets[layer] + neuron];
 }
 
 void NetworkViewer::handleEvents(sf::Event event) {
@@ -237,6 +535,11 @@ void NetworkViewer::handleEvents(sf::Event event) {
                 _networkView.zoom(1.0f - zoomSpeed);  // Zoom in
             } else if (event.key.code == sf::Keyboard::Dash) {
                 _networkView.zoom(1.0f + zoomSpeed);  // Zoom out
+            } else if (event.key.code == sf::Keyboard::B) {
+                _absMaxBundles = !_absMaxBundles;     // Mean or largest magnitude for grouped connections
+            } else if (event.key.code == sf::Keyboard::P) {
+                _showDashboard = !_showDashboard;     // Population dashboard
+                _worker.requestSummary(_showDashboard);
             }
             break;
 
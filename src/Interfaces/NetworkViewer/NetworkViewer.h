@@ -6,6 +6,7 @@
 #define KI_NETWORKVIEWER_H
 
 #include "../../NeuralNetwork/NeuralNetwork.h"
+#include "../../Training/TrainingWorker.h"
 #include "../../Utility/Utility.h"
 
 #include "SFML/Graphics.hpp"
@@ -27,8 +28,72 @@ private:
     bool _dragging = false;
     sf::Vector2i _prevMousePos;
 
-    NeuralNetwork &_network;
+    TrainingWorker &_worker;
 
+    // Host copy of the rendered network, only refreshed when its version changes
+    bool _mirrorValid = false;
+    uint64_t _mirrorVersion = 0;
+    std::vector<int> _topology;
+    std::vector<float> _parameters;
+    std::vector<size_t> _weightOffsets;
+    std::vector<size_t> _biasOffsets;
+
+    // Level of detail: when zoomed out, neurons are aggregated into groups and the connections into bundles.
+    // The bundle colours are reduced on the device, so only the small result is copied to the host.
+    bool _absMaxBundles = false; // Colour bundles by the weight with the largest magnitude instead of the mean
+    bool _groupsValid = false;
+    uint64_t _groupsVersion = 0;
+    int _groupsSize = 1;
+    bool _groupsAbsMax = false;
+    std::vector<std::vector<float>> _groupedWeights; // [groups of the layer, groups of the previous layer] per layer
+    std::vector<std::vector<float>> _groupedBiases;
+
+    // Elements described by the vertices, used to colour them
+    struct Connection {
+        int layer;
+        int neuron;
+        int prevNeuron;
+    };
+    struct Neuron {
+        int layer;
+        int neuron;
+    };
+
+    // Geometry of the rendered network, only rebuilt when the topology, the window size or the level of detail changes
+    std::vector<int> _layoutTopology;
+    unsigned int _layoutHeight = 0;
+    int _layoutGroup = 1;
+    bool _layoutCulled = false;
+    sf::FloatRect _layoutRegion;
+    std::vector<Connection> _connections;
+    std::vector<Neuron> _neurons;
+    std::vector<sf::Vertex> _connectionVertices;
+    std::vector<sf::Vertex> _neuronVertices;
+    sf::VertexBuffer _connectionBuffer{sf::Lines, sf::VertexBuffer::Dynamic};
+    sf::VertexBuffer _neuronBuffer{sf::Triangles, sf::VertexBuffer::Dynamic};
+
+    static constexpr float _neuronRadius = 10.0f;
+    static constexpr float _layerSpacing = 75.0f;
+    static constexpr float _neuronSpacing = 50.0f;
+    static constexpr float _outline = 2.5f;
+    static constexpr int _neuronSegments = 24; // Every neuron is a fill and an outline ring with this many segments
+    static constexpr float _minGroupSpacing = 8.0f; // Pixels between neurons before they are grouped
+    static constexpr size_t _maxConnections = 200000; // More connections are only built for the visible region
+
+    bool updateMirror(const NeuralNetwork &network);
+    bool updateGroups(const NeuralNetwork &network, int group);
+    int levelOfDetail();
+    sf::FloatRect visibleRegion();
+    bool layoutOutdated(int group);
+    void buildLayout(int group);
+    void updateColors();
+    float weight(size_t layer, int neuron, int prevNeuron) const;
+    float bias(size_t layer, int neuron) const;
+
+    // Population dashboard, toggled with P
+    bool _showDashboard = false;
+
+    void renderDashboard();
     void renderHUD();
     void renderNetwork();
     void handleEvents(sf::Event event);
@@ -36,7 +101,7 @@ private:
     sf::Color valueToColor(float value, float minValue, float maxValue);
 
 public:
-    NetworkViewer(sf::Vector2i size, std::string title, NeuralNetwork &network);
+    NetworkViewer(sf::Vector2i size, std::string title, TrainingWorker &worker);
 
     void update();
     void render(bool showHUD = true);
@@ -11,13 +11,16 @@ NeuralNetwork::NeuralNetwork(std::vector<int> &topology, std::vector<Utility::Ac
     }
 
     _activations = activations;
+    std::vector<af::array> weights;
+    std::vector<af::array> biases;
     for (int i = 1; i < topology.size(); ++i) {
         int &currentNeurons = topology[i];
         int &previousNeurons = topology[i - 1];
 
-        _weights.emplace_back(currentNeurons, previousNeurons, n);
-        _biases.emplace_back(currentNeurons, 1, n);
+        weights.emplace_back(currentNeurons, previousNeurons, n);
+        biases.emplace_back(currentNeurons, 1, n);
     }
+    assemble(weights, biases);
 }
 
 NeuralNetwork::NeuralNetwork(std::vector<int> &topology, std::vector<Utility::Activations> &activations, float min, float max, bool uniform, int n) {
@@ -27,17 +30,85 @@ NeuralNetwork::NeuralNetwork(std::vector<int> &topology, std::vector<Utility::Ac
     }
 
     _activations = activations;
+    std::vector<af::array> weights;
+    std::vector<af::array> biases;
     for (int i = 1; i < topology.size(); ++i) {
         int &currentNeurons = topology[i];
         int &previousNeurons = topology[i - 1];
 
         if(uniform){
-            _weights.emplace_back(af::randu(currentNeurons, previousNeurons, n) * (max - min) + min);
-            _biases.emplace_back(af::randu(currentNeurons, 1, n) * (max - min) + min);
+            weights.emplace_back(af::randu(currentNeurons, previousNeurons, n) * (max - min) + min);
+            biases.emplace_back(af::randu(currentNeurons, 1, n) * (max - min) + min);
         }else{
-            _weights.emplace_back(af::randn(currentNeurons, previousNeurons, n) * (max - min) + min);
-            _biases.emplace_back(af::randn(currentNeurons, 1, n) * (max - min) + min);
+            weights.emplace_back(af::randn(currentNeurons, previousNeurons, n) * (max - min) + min);
+            biases.emplace_back(af::randn(currentNeurons, 1, n) * (max - min) + min);
+        }
+    }
+    assemble(weights, biases);
+}
+
+void NeuralNetwork::assemble(std::vector<af::array> weights, std::vector<af::array> biases) {
+    _layout.clear();
+    _genome = af::array();
+    _parameters = 0;
+    if (weights.empty()) {
+        _weights.clear();
+        _biases.clear();
+        return;
+    }
+
+    // The layers are already in their final shape, so they serve as the forward arrays without splitting the genome
+    dim_t n = weights[0].dims(2);
+    for (int i = 0; i < weights.size(); ++i) {
+        dim_t count = weights[i].dims(0) * weights[i].dims(1);
+        Layer layer{weights[i].dims(0), weights[i].dims(1), _parameters, _parameters + count};
+        _parameters = layer.biases + layer.rows;
+        _layout.push_back(layer);
+
+        af::array parameters = af::join(0, af::moddims(weights[i], count, n), af::moddims(biases[i], layer.rows, n));
+        _genome = _genome.isempty() ? parameters : af::join(0, _genome, parameters);
+    }
+
+    _weights = std::move(weights);
+    _biases = std::move(biases);
+    index();
+}
+
+void NeuralNetwork::index() {
+    std::vector<unsigned int> neuron((size_t)_parameters);
+    std::vector<unsigned int> layerOf((size_t)_parameters);
+    _neurons = 0;
+    for (size_t i = 0; i < _layout.size(); ++i) {
+        const Layer &layer = _layout[i];
+        std::fill(layerOf.begin() + layer.weights, layerOf.begin() + layer.biases + layer.rows, (unsigned int)i);
+
+        // The weights are column-major, so the row of a weight is its neuron
+        for (dim_t j = layer.weights; j < layer.biases; ++j) {
+            neuron[j] = (unsigned int)(_neurons + (j - layer.weights) % layer.rows);
         }
+        for (dim_t row = 0; row < layer.rows; ++row) {
+            neuron[layer.biases + row] = (unsigned int)(_neurons + row);
+        }
+        _neurons += layer.rows;
+    }
+    _neuronOf = af::array(_parameters, neuron.data());
+    _layerOf = af::array(_parameters, layerOf.data());
+}
+
+void NeuralNetwork::split() {
+    _weights.clear();
+    _biases.clear();
+    if (_genome.isempty()) {
+        return;
+    }
+
+    // One copy per layer whenever the genome changed, the forward pass then works on contiguous arrays
+    dim_t n = _genome.dims(1);
+    for (auto &layer : _layout) {
+        af::seq weights((double)layer.weights, (double)(layer.biases - 1));
+        af::seq biases((double)layer.biases, (double)(layer.biases + layer.rows - 1));
+        _weights.push_back(af::moddims(_genome(weights, af::span), layer.rows, layer.columns, n));
+        _biases.push_back(af::moddims(_genome(biases, af::span), layer.rows, 1, n));
     }
 }
 
@@ -58,10 +129,13 @@ af::array NeuralNetwork::feed_forward(af::array &input) {
     // Get the batch size from the input
     dim_t batchSize = value.dims()[3];
 
+    // Multiple samples can also be passed as columns, the matmul handles them without tiling the weights
+    dim_t samples = value.dims()[1];
+
     for (int i = 0; i < _weights.size(); ++i) {
 
         af::array weights = af::tile(_weights[i], 1, 1, 1, batchSize);
-        af::array biases = af::tile(_biases[i], 1, 1, 1, batchSize);
+        af::array biases = af::tile(_biases[i], 1, samples, 1, batchSize);
 
         // z = activation(weights * inputs + biases)
         value = af::matmul(weights, value) + biases;
@@ -76,7 +150,7 @@ af::array NeuralNetwork::feed_forward(std::vector<float> &input){
     return feed_forward(in);
 }
 
-af::array NeuralNetwork::feed_forward_single(af::array &input, int index){
+af::array NeuralNetwork::feed_forward_single(af::array &input, int index) const {
     af::array value = input;
 
     if (_weights.empty()) {
@@ -113,132 +187,203 @@ af::array NeuralNetwork::feed_forward_single(std::vector<float> &input, int inde
     return feed_forward_single(in, index);
 }
 
-void NeuralNetwork::breed(std::vector<float> &fitness, int winners, float min, float max, bool uniform) {
+af::array NeuralNetwork::error(af::array &inputs, af::array &targets) {
     if (_weights.empty()) {
         std::cerr << "The network does not possess any layers!" << "\n";
-        return;
+        return {};
     }
 
-    unsigned int numNetworks = _weights[0].dims()[2];
+    int numNetworks = networks();
+    af::array error = af::constant(0.0f, numNetworks);
 
-    if(winners > numNetworks){
-        std::cerr << "The number of winners cannot be higher than the number of networks!\n";
-        return;
+    if (inputs.dims()[0] != _weights[0].dims()[1] || targets.dims()[0] != _weights.back().dims()[0] ||
+        inputs.dims()[1] != targets.dims()[1]) {
+        std::cerr << "The samples must match the input and output dimensions of the network!" << "\n";
+        return error;
     }
 
-    // Buffer for child networks
-    std::vector<af::array> weights;
-    std::vector<af::array> biases;
-
-    // Already apply the mutation values at start
-    for (int i = 0; i < _weights.size(); ++i) {
-        if(uniform){
-            weights.emplace_back(af::randu(_weights[i].dims()) * (max - min) + min);
-            biases.emplace_back(af::randu(_biases[i].dims()) * (max - min) + min);
-        }else{
-            weights.emplace_back(af::randn(_weights[i].dims()) * (max - min) + min);
-            biases.emplace_back(af::randn(_biases[i].dims()) * (max - min) + min);
-        }
+    // Every chunk is fed to all networks at once, so its size is limited by the widest layer
+    dim_t widest = _weights[0].dims()[1];
+    for (auto &weights : _weights) {
+        widest = std::max(widest, weights.dims()[0]);
     }
 
-    // Find the best neural networks
-    auto selectedNetworks = Utility::find_top_n(fitness, winners);
+    dim_t samples = inputs.dims()[1];
+    dim_t chunkSize = std::max<dim_t>(1, _evaluationBudget / (widest * numNetworks));
 
-    // Copy the winners into the children to preserve them
-    af::array selectedIdxArray(1, selectedNetworks.size(), selectedNetworks.data());
+    for (dim_t start = 0; start < samples; start += chunkSize) {
+        af::seq range(start, std::min(start + chunkSize, samples) - 1);
 
-    for (int layer = 0; layer < _weights.size(); ++layer) {
-        af::array selectedWeights = af::lookup(_weights[layer], selectedIdxArray.as(u32), 2);
-        af::array selectedBiases = af::lookup(_biases[layer], selectedIdxArray.as(u32), 2);
+        // Samples are stored as columns: [features, samples, networks]
+        af::array in = af::tile(inputs(af::span, range), 1, 1, numNetworks);
+        af::array expected = af::tile(targets(af::span, range), 1, 1, numNetworks);
 
-        // Assign the selected weights and biases to the first numSelectedNetworks positions
-        af::seq destSeq(0, selectedNetworks.size() - 1);
+        af::array result = feed_forward(in);
 
-        weights[layer](af::span, af::span, destSeq) = selectedWeights;
-        biases[layer](af::span, af::span, destSeq) = selectedBiases;
+        // Sum the squared error over all outputs and samples of each network
+        error += af::flat(af::sum(af::sum(af::pow(result - expected, 2), 0), 1));
     }
 
+    return error;
+}
+
+std::vector<int> NeuralNetwork::breed(std::vector<float> &fitness, int winners, float min, float max, bool uniform) {
+    if (_genome.isempty()) {
+        std::cerr << "The network does not possess any layers!" << "\n";
+        return {};
+    }
+
+    unsigned int numNetworks = _genome.dims(1);
+    dim_t parameters = _genome.dims(0);
+
+    if(winners > numNetworks){
+        std::cerr << "The number of winners cannot be higher than the number of networks!\n";
+        return {};
+    }
+
+    // The forward arrays are outdated after breeding anyway, releasing them keeps only the genomes on the device
+    _weights.clear();
+    _biases.clear();
+
+    // Find the best neural networks
+    auto selectedNetworks = Utility::find_top_n(fitness, winners);
+    af::array selectedIdxArray((dim_t)selectedNetworks.size(), selectedNetworks.data());
+
     // Decide the breeding pairs
     unsigned int numPairs = numNetworks - winners;
     std::vector<unsigned int> n1Vec(numPairs), n2Vec(numPairs);
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_int_distribution<> dis(0, selectedNetworks.size() - 1);
 
     for(int i = 0; i < numPairs; ++i){
-        int idx1 = dis(gen);
-        int idx2 = dis(gen);
+        int idx1 = dis(_generator);
+        int idx2 = dis(_generator);
 
         n1Vec[i] = idx1;
         n2Vec[i] = idx2;
     }
-    af::array n1Array(1, numPairs, n1Vec.data());
-    af::array n2Array(1, numPairs, n2Vec.data());
+    af::array n1Array, n2Array;
+    if (numPairs > 0) {
+        n1Array = af::array(numPairs, n1Vec.data()).as(u32);
+        n2Array = af::array(numPairs, n2Vec.data()).as(u32);
+    }
 
-    // Cross the values of the networks
-    for (int layer = 0; layer < _weights.size(); ++layer) {
-        af::dim4 wDims = _weights[layer].dims();
-        af::dim4 bDims = _biases[layer].dims();
+    // Buffer for the children, already holding the mutation values
+    af::array genome;
+    if (_adaptive) {
+        // Every network starts with the strength of the fixed range
+        if (_strength.elements() != numNetworks) {
+            _strength = af::constant((max - min) / 2.0f, numNetworks);
+        }
 
-        // Generate masks for all network pairs
-        af::array wMasks = af::randu(wDims[0], wDims[1], numPairs) > 0.5f;
-        af::array bMasks = af::randu(bDims[0], bDims[1], numPairs) > 0.5f;
+        // The winners keep their strength, the children inherit the geometric mean of their parents' strengths,
+        // perturbed log-normally
+        af::array selectedStrength = af::lookup(_strength, selectedIdxArray.as(u32));
+        af::array strength = af::constant(0.0f, numNetworks);
+        strength(af::seq(0, (double)selectedNetworks.size() - 1)) = selectedStrength;
+        if (numPairs > 0) {
+            float rate = _adaptationRate > 0.0f ? _adaptationRate : 1.0f / std::sqrt((float)parameters);
+            af::array inherited = af::lookup(selectedStrength, n1Array) * af::lookup(selectedStrength, n2Array);
+            inherited = af::sqrt(inherited);
+            inherited *= af::exp(rate * af::randn(numPairs));
+            strength(af::seq(winners, winners + numPairs - 1)) = af::clamp(inherited, 1e-6, 1e3);
+        }
+        _strength = strength;
+
+        // Symmetric noise around the center of the range, scaled per network
+        af::array noise = uniform ? af::randu(parameters, numNetworks) * 2.0f - 1.0f
+                                  : af::randn(parameters, numNetworks);
+        genome = noise * af::tile(af::moddims(strength, 1, numNetworks), (unsigned int)parameters) + (max + min) / 2.0f;
+    } else if(uniform){
+        genome = af::randu(parameters, numNetworks) * (max - min) + min;
+    }else{
+        genome = af::randn(parameters, numNetworks) * (max - min) + min;
+    }
 
-        // Extract parent weights and biases using the lookup function along the third dimension
-        af::array parent1Weights = af::lookup(_weights[layer], n1Array.as(u32), 2);
-        af::array parent2Weights = af::lookup(_weights[layer], n2Array.as(u32), 2);
+    // Copy the winners into the children to preserve them
+    af::array selectedGenomes = af::lookup(_genome, selectedIdxArray.as(u32), 1);
+    genome(af::span, af::seq(0, (double)selectedNetworks.size() - 1)) = selectedGenomes;
 
-        af::array parent1Biases = af::lookup(_biases[layer], n1Array.as(u32), 2);
-        af::array parent2Biases = af::lookup(_biases[layer], n2Array.as(u32), 2);
+    if (numPairs > 0) {
+        // Cross the values of the parents, all pairs at once
+        af::array parent1 = af::lookup(selectedGenomes, n1Array, 1);
+        af::array parent2 = af::lookup(selectedGenomes, n2Array, 1);
 
-        // Perform crossover using masks
-        af::array newWeights = parent1Weights * wMasks + parent2Weights * (1 - wMasks);
-        af::array newBiases = parent1Biases * bMasks + parent2Biases * (1 - bMasks);
+        genome(af::span, af::seq(winners, winners + numPairs - 1)) += cross(parent1, parent2);
+    }
 
-        // Assign the new weights and biases to the appropriate slices
-        af::seq destSeq(winners, winners + numPairs - 1);
+    _genome = genome;
+    split();
+    _version++;
 
-        weights[layer](af::span, af::span, destSeq) += newWeights;
-        biases[layer](af::span, af::span, destSeq) += newBiases;
-    }
+    return selectedNetworks;
+}
 
-    // Copy the children into the networks
-    for (int layer = 0; layer < _weights.size(); ++layer) {
-        _weights[layer] = weights[layer];
-        _biases[layer] = biases[layer];
+af::array NeuralNetwork::cross(const af::array &first, const af::array &second) const {
+    dim_t parameters = first.dims(0);
+    dim_t pairs = first.dims(1);
+
+    switch (_crossover) {
+        case Crossover::Neuron:
+        case Crossover::Layer: {
+            // Every parameter belongs to a segment that is inherited as a whole, so only one draw per segment is needed
+            bool neurons = _crossover == Crossover::Neuron;
+            af::array draws = af::randu(neurons ? _neurons : (dim_t)_layout.size(), pairs);
+            af::array mask = af::lookup(draws, neurons ? _neuronOf : _layerOf, 0) > 0.5f;
+            return af::select(mask, first, second);
+        }
+        case Crossover::SinglePoint:
+        case Crossover::TwoPoint: {
+            // Random cut points per child, compared with the position of every parameter
+            af::array position = af::range(af::dim4(parameters, pairs), 0, f32);
+            af::array cut = af::tile(af::floor(af::randu(1, pairs) * (float)parameters), (unsigned int)parameters);
+            if (_crossover == Crossover::SinglePoint) {
+                return af::select(position < cut, first, second);
+            }
+            af::array other = af::tile(af::floor(af::randu(1, pairs) * (float)parameters), (unsigned int)parameters);
+            af::array inside = position >= af::min(cut, other) && position < af::max(cut, other);
+            return af::select(inside, second, first);
+        }
+        case Crossover::Arithmetic: {
+            af::array blend = af::tile(af::randu(1, pairs), (unsigned int)parameters);
+            return blend * first + (1.0f - blend) * second;
+        }
+        case Crossover::Uniform:
+        default:
+            return af::select(af::randu(parameters, pairs) > 0.5f, first, second);
     }
 }
 
-void NeuralNetwork::breed(af::array &fitness, int winners, float min, float max, bool uniform){
+std::vector<int> NeuralNetwork::breed(af::array &fitness, int winners, float min, float max, bool uniform){
     auto in = Utility::arrayToVector(fitness);
-    breed(in, winners, min, max, uniform);
+    return breed(in, winners, min, max, uniform);
 }
 
-int NeuralNetwork::networks() {
-    if (_weights.empty()) {
+int NeuralNetwork::networks() const {
+    if (_genome.isempty()) {
         std::cerr << "The network does not possess any layers!" << "\n";
         return -1;
     }
-    return _weights[0].dims()[2];
+    return (int)_genome.dims(1);
 }
 
-int NeuralNetwork::size() {
+int NeuralNetwork::size() const {
     return (int)_weights.size() + 1;
 }
 
-size_t NeuralNetwork::bytes() {
-    if (_weights.empty()) {
+size_t NeuralNetwork::bytes() const {
+    if (_genome.isempty()) {
         std::cerr << "The network does not possess any layers!" << "\n";
         return -1;
     }
-    size_t size = 0;
-    for (int i = 0; i < _weights.size(); ++i) {
-        size += _biases[i].bytes() + _weights[i].bytes();
+    // The forward arrays are a second copy of the parameters
+    size_t bytes = _genome.bytes();
+    for (size_t i = 0; i < _weights.size(); ++i) {
+        bytes += _weights[i].bytes() + _biases[i].bytes();
     }
-    return size;
+    return bytes;
 }
 
-std::vector<int> NeuralNetwork::topology() {
+std::vector<int> NeuralNetwork::topology() const {
     std::vector<int> output;
 
     for (int i = 0; i < _weights.size(); ++i) {
@@ -255,6 +400,85 @@ std::vector<int> NeuralNetwork::topology() {
     return output;
 }
 
+NeuralNetwork NeuralNetwork::slice(int index, int amount) const {
+    if (_genome.isempty() || index < 0 || index + amount > networks()) {
+        std::cerr << "The networks " << index << " to " << index + amount - 1 << " do not exist!\n";
+        return {};
+    }
+
+    // A new genome, so the slice stays valid while this population keeps breeding
+    return select(af::range(af::dim4(amount), 0, u32) + (unsigned int)index);
+}
+
+NeuralNetwork NeuralNetwork::select(const af::array &indices) const {
+    NeuralNetwork network;
+
+    if (_genome.isempty()) {
+        std::cerr << "The network does not possess any layers!" << "\n";
+        return network;
+    }
+
+    // Gathers the networks in the order of the indices
+    network._genome = af::lookup(_genome, indices.as(u32), 1);
+    network._layout = _layout;
+    network._parameters = _parameters;
+    network._neuronOf = _neuronOf;
+    network._layerOf = _layerOf;
+    network._neurons = _neurons;
+    network._activations = _activations;
+    network._crossover = _crossover;
+    network._adaptive = _adaptive;
+    network._adaptationRate = _adaptationRate;
+    if (!_strength.isempty()) {
+        network._strength = af::lookup(_strength, indices.as(u32));
+    }
+    network._version = _version;
+    network.split();
+
+    return network;
+}
+
+af::array NeuralNetwork::fingerprint(float quantum) const {
+    if (_genome.isempty()) {
+        std::cerr << "The network does not possess any layers!" << "\n";
+        return {};
+    }
+
+    dim_t count = _genome.dims(0);
+    auto n = (unsigned int)_genome.dims(1);
+
+    af::array quantised = af::clamp(af::round(_genome / quantum), -2147483648.0, 2147483647.0);
+    af::array bits = quantised.as(s32).as(u32);
+
+    // Two independent multiply-sum hashes over the quantised genome, every position has its own multipliers
+    af::array position = af::range(af::dim4(count, 1), 0, u32);
+    af::array first = af::tile((position * 2654435761u) | 1u, 1, n);
+    af::array second = af::tile((position * 2246822519u + 3266489917u) | 1u, 1, n);
+
+    af::array a = (bits ^ first) * 2246822507u;
+    af::array b = (bits + second) * 3266489909u;
+    af::array low = af::moddims(af::sum(a ^ (a >> 15u), 0), n);
+    af::array high = af::moddims(af::sum(b ^ (b >> 13u), 0), n);
+
+    return (high.as(u64) << 32u) | low.as(u64);
+}
+
+std::vector<float> NeuralNetwork::parameters(int index) const {
+    if (_genome.isempty() || index < 0 || index >= networks()) {
+        std::cerr << "The network " << index << " does not exist!\n";
+        return {};
+    }
+
+    // The column of the genome already holds the weights (column-major) followed by the biases of every layer
+    return Utility::arrayToVector(_genome(af::span, index));
+}
+
+void NeuralNetwork::seed(unsigned int seed) {
+    // Makes the initialization, mutation and pairing reproducible
+    af::setSeed(seed);
+    _generator.seed(seed);
+}
+
 bool NeuralNetwork::save(std::string path, int n)
 {
     // Ensure that n does not exceed the actual number of networks
@@ -274,24 +498,27 @@ bool NeuralNetwork::save(std::string path, int n)
     j["activations"]  = activationVec;
     j["num_networks"] = numNetworks;
 
-    nlohmann::json layersJson = nlohmann::json::array();
-    for (size_t i = 0; i < _weights.size(); i++) {
-        // Slice out only [0..n-1] in the 3rd dimension
-        af::array wSub = _weights[i](af::span, af::span, af::seq(0, n - 1), af::span);
-        af::array bSub = _biases[i](af::span, af::span, af::seq(0, n - 1), af::span);
-
-        // Retrieve shapes for the partial slices
-        af::dim4 wShape = wSub.dims();
-        af::dim4 bShape = bSub.dims();
+    // The genomes of the first n networks are the first columns, so they are copied to the host with a single
+    // transfer. The file keeps the format with one entry per layer, so they are split into the layers on the host.
+    std::vector<float> genome = Utility::arrayToVector(_genome(af::span, af::seq(0, n - 1)));
+    auto parameters = (size_t)_parameters;
 
-        // Convert the partial arrays to std::vector<float>
-        std::vector<float> wData = Utility::arrayToVector(wSub);
-        std::vector<float> bData = Utility::arrayToVector(bSub);
+    nlohmann::json layersJson = nlohmann::json::array();
+    for (auto &layer : _layout) {
+        // Gather the weights [rows, columns, n] and biases [rows, 1, n] of the layer from the columns of the genome
+        auto weightCount = (size_t)(layer.biases - layer.weights);
+        std::vector<float> wData(weightCount * n);
+        std::vector<float> bData((size_t)layer.rows * n);
+        for (int k = 0; k < n; ++k) {
+            auto column = genome.begin() + (long)(k * parameters);
+            std::copy(column + layer.weights, column + layer.biases, wData.begin() + (long)(k * weightCount));
+            std::copy(column + layer.biases, column + layer.biases + layer.rows, bData.begin() + k * layer.rows);
+        }
 
         // Build JSON layer entry
         nlohmann::json layerJson;
-        layerJson["weights_shape"] = { (int)wShape[0], (int)wShape[1], (int)wShape[2], (int)wShape[3] };
-        layerJson["biases_shape"]  = { (int)bShape[0], (int)bShape[1], (int)bShape[2], (int)bShape[3] };
+        layerJson["weights_shape"] = { (int)layer.rows, (int)layer.columns, n, 1 };
+        layerJson["biases_shape"]  = { (int)layer.rows, 1, n, 1 };
 
         layerJson["weights_data"]  = wData;
         layerJson["biases_data"]   = bData;
@@ -299,6 +526,9 @@ bool NeuralNetwork::save(std::string path, int n)
         layersJson.push_back(layerJson);
     }
     j["layers"] = layersJson;
+    if (!_strength.isempty()) {
+        j["mutation_strength"] = Utility::arrayToVector(_strength(af::seq(0, n - 1)));
+    }
 
     // Write to file
     std::ofstream file(path);
@@ -338,10 +568,10 @@ bool NeuralNetwork::load(std::string path) {
         loadedActivations[i] = static_cast<Utility::Activations>(actVec[i]);
     }
 
-    int networks = _weights[0].dims(2);
+    int networks = _genome.isempty() ? net : this->networks();
 
-    _weights.clear();
-    _biases.clear();
+    std::vector<af::array> weights;
+    std::vector<af::array> biases;
     _activations = loadedActivations;
 
     // Parse each layer from the JSON
@@ -388,9 +618,24 @@ bool NeuralNetwork::load(std::string path) {
         }
         // If net <= savedNetworks, or savedNetworks == 0, we do nothing special.
 
-        _weights.push_back(wArr);
-        _biases.push_back(bArr);
+        weights.push_back(wArr);
+        biases.push_back(bArr);
+    }
+    assemble(weights, biases);
+
+    // The mutation strengths are repeated like the networks, without them the first breed starts over
+    _strength = af::array();
+    if (j.contains("mutation_strength") && !_genome.isempty()) {
+        auto saved = j["mutation_strength"].get<std::vector<float>>();
+        if (!saved.empty()) {
+            std::vector<float> strength((size_t)this->networks());
+            for (size_t i = 0; i < strength.size(); ++i) {
+                strength[i] = saved[i % saved.size()];
+            }
+            _strength = Utility::vectorToArray(strength);
+        }
     }
+    _version++;
 
     return true;
 }
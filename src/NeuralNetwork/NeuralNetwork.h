@@ -8,6 +8,7 @@
 #include <arrayfire.h>
 #include <vector>
 #include <random>
+#include <cstdint>
 #include <chrono>
 #include <fstream>
 #include <sstream>
@@ -16,12 +17,68 @@
 #include "../Utility/Utility.h"
 
 class NeuralNetwork {
+public:
+    // How the parameters of two parents are combined into a child
+    enum class Crossover : int {
+        Uniform,        // Every parameter from a random parent
+        Neuron,         // Every neuron's incoming weights and bias from one parent
+        Layer,          // Every layer from one parent
+        SinglePoint,    // The genome up to a random point from the first parent, the rest from the second
+        TwoPoint,       // The genome between two random points from the second parent
+        Arithmetic      // A random blend of both parents per child
+    };
+
 private:
-    // Neural network values
+    // Position of a layer's parameters within the parameters of one network
+    struct Layer {
+        dim_t rows;
+        dim_t columns;
+        dim_t weights; // Offset of the weights (column-major), the biases follow
+        dim_t biases;
+    };
+
+    // All parameters of every network in one allocation: [parameters, networks]. Every column holds the weights and
+    // biases of one layer after the other, so breeding, hashing and transfers work on the whole genome at once.
+    af::array _genome;
+    std::vector<Layer> _layout;
+    dim_t _parameters = 0;      // Parameters of one network
+
+    // Neuron and layer of every parameter of a network (u32 [parameters]) for the structure-aware crossovers
+    af::array _neuronOf;
+    af::array _layerOf;
+    dim_t _neurons = 0;
+
+    // Per-layer arrays [rows, columns, networks] for the forward pass. A layer is a strided block of rows of the
+    // genome, which ArrayFire cannot reshape without a copy, so they are rebuilt once whenever the genome changes
+    // and released while breeding.
     std::vector<af::array> _weights;
     std::vector<af::array> _biases;
     std::vector<Utility::Activations> _activations;
 
+    // Increases whenever the parameters change (breed, load)
+    uint64_t _version = 0;
+
+    Crossover _crossover = Crossover::Uniform;
+
+    // Self-adaptive mutation: every network carries its own mutation strength [networks], created by the first breed
+    bool _adaptive = false;
+    float _adaptationRate = 0.0f;   // Learning rate of the log-normal perturbation, 0 uses 1 / sqrt(parameters)
+    af::array _strength;
+
+    // Random generator used for the breeding pairs
+    std::mt19937 _generator{std::random_device{}()};
+
+    // Maximum number of activations evaluated at once by error()
+    static constexpr dim_t _evaluationBudget = 1 << 24;
+
+    // Joins the layers into the genome or splits the genome into the layers
+    void assemble(std::vector<af::array> weights, std::vector<af::array> biases);
+    void split();
+    void index();
+
+    // Children of the parents [parameters, pairs], combined according to the crossover
+    af::array cross(const af::array &first, const af::array &second) const;
+
 public:
     // Constructors
     NeuralNetwork() = default;
@@ -31,29 +88,45 @@ public:
     NeuralNetwork(std::string path);
 
     // Getter and setter
-    [[nodiscard]] std::vector<af::array> &weights() { return _weights; }
-    [[nodiscard]] std::vector<af::array> &biases() { return _biases; }
+    // The layers are read-only, all changes go through the genome
+    [[nodiscard]] std::vector<af::array> const &weights() const { return _weights; }
+    [[nodiscard]] std::vector<af::array> const &biases() const { return _biases; }
+    [[nodiscard]] af::array const &genome() const { return _genome; }
     [[nodiscard]] std::vector<Utility::Activations> &activationValues() { return _activations; }
-    [[nodiscard]] af::array &weights(int i) { return _weights[i]; }
-    [[nodiscard]] af::array &biases(int i) { return _biases[i]; }
+    [[nodiscard]] af::array const &weights(int i) const { return _weights[i]; }
+    [[nodiscard]] af::array const &biases(int i) const { return _biases[i]; }
     [[nodiscard]] Utility::Activations &activations(int i) { return _activations[i]; }
+    [[nodiscard]] uint64_t version() const { return _version; }
+    [[nodiscard]] Crossover crossover() const { return _crossover; }
+    void crossover(Crossover value) { _crossover = value; }
+    [[nodiscard]] af::array const &mutationStrength() const { return _strength; }
+    void adaptiveMutation(bool enabled, float rate = 0.0f) { _adaptive = enabled; _adaptationRate = rate; }
 
     // Functions
     bool load(std::string path);
     bool save(std::string path, int amount = 1);
-    int networks();
-    int size();
-    size_t bytes();
-    std::vector<int> topology();
+    int networks() const;
+    int size() const;
+    size_t bytes() const;
+    std::vector<int> topology() const;
+    NeuralNetwork slice(int index, int amount = 1) const;
+    NeuralNetwork select(const af::array &indices) const;
+    std::vector<float> parameters(int index) const;
+    // 64 bit hash of every network (u64), equal for networks whose parameters round to the same multiples of quantum
+    af::array fingerprint(float quantum = 1e-6f) const;
+    void seed(unsigned int seed);
 
     af::array feed_forward(af::array &input);
     af::array feed_forward(std::vector<float> &input);
 
-    af::array feed_forward_single(af::array &input, int index);
+    af::array feed_forward_single(af::array &input, int index) const;
     af::array feed_forward_single(std::vector<float> &input, int index);
 
-    void breed(af::array &fitness, int winners, float min, float max, bool uniform = true);
-    void breed(std::vector<float> &fitness, int winners, float min, float max, bool uniform = true);
+    af::array error(af::array &inputs, af::array &targets);
+
+    // Returns the indices of the winners in the order they are copied to the front
+    std::vector<int> breed(af::array &fitness, int winners, float min, float max, bool uniform = true);
+    std::vector<int> breed(std::vector<float> &fitness, int winners, float min, float max, bool uniform = true);
 };
 
 
@@ -0,0 +1,46 @@
+#ifndef KI_DATASOURCE_H
+#define KI_DATASOURCE_H
+
+#include <arrayfire.h>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Samples the Trainer evaluates the population on. A generation calls begin() once and then requests the samples
+// in consecutive batches, so sources can keep everything on the device or stream it from disk.
+class DataSource {
+public:
+    virtual ~DataSource() = default;
+
+    [[nodiscard]] virtual size_t size() const = 0;
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] virtual int inputSize() const = 0;
+    [[nodiscard]] virtual int outputSize() const = 0;
+
+    // Increases whenever samples are replaced or removed, but not when samples are only appended. Results computed on
+    // the first samples stay valid as long as the epoch is the same.
+    [[nodiscard]] virtual uint64_t epoch() const = 0;
+
+    // Samples replaced in place since the epoch started. A source that only appends and replaces whole epochs
+    // never has any.
+    [[nodiscard]] virtual size_t replacements() const { return 0; }
+
+    // Indices [n] (u32) of the samples replaced since the first `from` replacements and below `limit`, with the
+    // inputs and targets they had before. Every index appears once, with its oldest value.
+    virtual void replaced(size_t from, size_t limit, af::array &indices, af::array &inputs, af::array &targets) {}
+
+    // Largest batch the source hands out at once
+    [[nodiscard]] virtual size_t maxBatch() const { return std::numeric_limits<size_t>::max(); }
+
+    // Starts a generation and returns its number of samples, they must not change until the next call
+    virtual size_t begin() = 0;
+
+    // Inputs [inputSize, count] and targets [outputSize, count] of the samples [start, start + count)
+    virtual void batch(size_t start, size_t count, af::array &inputs, af::array &targets) = 0;
+
+    // The same for the samples at the given indices, e.g. a random subset
+    virtual void gather(const af::array &indices, af::array &inputs, af::array &targets) = 0;
+};
+
+
+#endif //KI_DATASOURCE_H
@@ -0,0 +1,302 @@
+#include "Dataset.h"
+
+Dataset::Dataset(int inputs, int outputs) : _inputs(inputs), _outputs(outputs) {
+}
+
+bool Dataset::load(std::string path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for reading: " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+
+        // Skip empty lines, comments and a header
+        if (line.empty() || line[0] == '#' || (lineNumber == 1 && std::isalpha((unsigned char)line[0]))) {
+            continue;
+        }
+
+        std::vector<float> values;
+        std::stringstream stream(line);
+        std::string item;
+        try {
+            while (std::getline(stream, item, ',')) {
+                values.push_back(std::stof(item));
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Invalid value in line " << lineNumber << " of " << path << "\n";
+            file.close();
+            return false;
+        }
+
+        if (values.size() != _inputs + 1) {
+            std::cerr << "Line " << lineNumber << " of " << path << " must contain " << _inputs
+                      << " inputs and a label!\n";
+            file.close();
+            return false;
+        }
+
+        // The label selects one of the outputs, so it has to be a whole number in range
+        float label = values.back();
+        if (label != std::floor(label) || label < 0 || label >= (float)_outputs) {
+            std::cerr << "Invalid label in line " << lineNumber << " of " << path << ", it must be between 0 and "
+                      << _outputs - 1 << "!\n";
+            file.close();
+            return false;
+        }
+
+        values.pop_back();
+        add(values, (int)label);
+    }
+
+    file.close();
+    return true;
+}
+
+bool Dataset::save(std::string path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << path << "\n";
+        return false;
+    }
+
+    for (size_t sample = 0; sample < size(); ++sample) {
+        for (int i = 0; i < _inputs; ++i) {
+            file << _inputData[sample * _inputs + i] << ",";
+        }
+
+        // The label is the output with the highest target value
+        auto target = _targetData.begin() + (long)(sample * _outputs);
+        file << std::distance(target, std::max_element(target, target + _outputs)) << "\n";
+    }
+
+    file.close();
+    return true;
+}
+
+void Dataset::add(std::vector<float> const &input, int label) {
+    if (label < 0 || label >= _outputs) {
+        std::cerr << "The label " << label << " does not belong to any output of the dataset!\n";
+        return;
+    }
+    add(input, Utility::mapIndexToVector(label, _outputs));
+}
+
+void Dataset::add(std::vector<float> const &input, std::vector<float> const &target) {
+    if (input.size() != _inputs || target.size() != _outputs) {
+        std::cerr << "The sample does not match the dimensions of the dataset!\n";
+        return;
+    }
+
+    _inputData.insert(_inputData.end(), input.begin(), input.end());
+    _targetData.insert(_targetData.end(), target.begin(), target.end());
+    _version++;
+}
+
+void Dataset::append(const Dataset &other) {
+    if (other._inputs != _inputs || other._outputs != _outputs) {
+        std::cerr << "The samples do not match the dimensions of the dataset!\n";
+        return;
+    }
+    if (other.empty()) {
+        return;
+    }
+
+    _inputData.insert(_inputData.end(), other._inputData.begin(), other._inputData.end());
+    _targetData.insert(_targetData.end(), other._targetData.begin(), other._targetData.end());
+    _version++;
+}
+
+void Dataset::replace(const std::vector<size_t> &indices, const Dataset &samples) {
+    if (samples._inputs != _inputs || samples._outputs != _outputs || samples.size() != indices.size()) {
+        std::cerr << "The samples do not match the dimensions of the dataset!\n";
+        return;
+    }
+
+    for (size_t i = 0; i < indices.size(); ++i) {
+        size_t index = indices[i];
+        if (index >= size()) {
+            std::cerr << "The sample " << index << " does not exist!\n";
+            continue;
+        }
+
+        auto input = _inputData.begin() + (long)(index * _inputs);
+        auto target = _targetData.begin() + (long)(index * _outputs);
+        _replacedIndices.push_back(index);
+        _replacedInputs.insert(_replacedInputs.end(), input, input + _inputs);
+        _replacedTargets.insert(_replacedTargets.end(), target, target + _outputs);
+
+        std::copy_n(samples._inputData.begin() + (long)(i * _inputs), _inputs, input);
+        std::copy_n(samples._targetData.begin() + (long)(i * _outputs), _outputs, target);
+        if (index < _uploaded) {
+            _dirty.push_back(index);
+        }
+    }
+    _version++;
+
+    // A long history costs more than starting over
+    if (_replacedIndices.size() > std::max(size(), _minCapacity)) {
+        newEpoch();
+    }
+}
+
+void Dataset::replaced(size_t from, size_t limit, af::array &indices, af::array &inputs, af::array &targets) {
+    std::vector<unsigned int> index;
+    std::vector<float> input;
+    std::vector<float> target;
+
+    // The first replacement of an index holds the value it had before
+    std::vector<bool> seen(limit, false);
+    for (size_t i = from; i < _replacedIndices.size(); ++i) {
+        size_t sample = _replacedIndices[i];
+        if (sample >= limit || seen[sample]) {
+            continue;
+        }
+        seen[sample] = true;
+        index.push_back((unsigned int)sample);
+        input.insert(input.end(), _replacedInputs.begin() + (long)(i * _inputs),
+                     _replacedInputs.begin() + (long)((i + 1) * _inputs));
+        target.insert(target.end(), _replacedTargets.begin() + (long)(i * _outputs),
+                      _replacedTargets.begin() + (long)((i + 1) * _outputs));
+    }
+
+    if (index.empty()) {
+        indices = inputs = targets = af::array();
+        return;
+    }
+    indices = af::array((dim_t)index.size(), index.data());
+    inputs = af::array(_inputs, (dim_t)index.size(), input.data());
+    targets = af::array(_outputs, (dim_t)index.size(), target.data());
+}
+
+void Dataset::newEpoch() {
+    _epoch++;
+    _replacedIndices.clear();
+    _replacedInputs.clear();
+    _replacedTargets.clear();
+}
+
+void Dataset::assign(Dataset &&other) {
+    // The device memory can only be reused for the same dimensions
+    if (other._inputs != _inputs || other._outputs != _outputs) {
+        _deviceInputs = af::array();
+        _deviceTargets = af::array();
+    }
+
+    _inputs = other._inputs;
+    _outputs = other._outputs;
+    _inputData = std::move(other._inputData);
+    _targetData = std::move(other._targetData);
+    _uploaded = 0;
+    _dirty.clear();
+    _version++;
+    newEpoch();
+}
+
+void Dataset::clear() {
+    _inputData.clear();
+    _targetData.clear();
+    _uploaded = 0;
+    _dirty.clear();
+    _version++;
+    newEpoch();
+}
+
+void Dataset::upload() {
+    size_t samples = size();
+    if (_uploaded >= samples) {
+        uploadReplaced();
+        return;
+    }
+
+    // Grow geometrically, so appending a few samples per frame does not reallocate every time
+    size_t capacity = _deviceInputs.isempty() ? 0 : (size_t)_deviceInputs.dims(1);
+    if (samples > capacity) {
+        size_t grown = std::max({samples, 2 * capacity, _minCapacity});
+        af::array inputs = af::constant(0.0f, _inputs, (dim_t)grown);
+        af::array targets = af::constant(0.0f, _outputs, (dim_t)grown);
+
+        if (_uploaded > 0) {
+            af::seq kept((double)_uploaded);
+            inputs(af::span, kept) = _deviceInputs(af::span, kept);
+            targets(af::span, kept) = _deviceTargets(af::span, kept);
+        }
+
+        _deviceInputs = inputs;
+        _deviceTargets = targets;
+    }
+
+    // Only the new samples are copied
+    size_t count = samples - _uploaded;
+    af::seq range((double)_uploaded, (double)(samples - 1));
+    _deviceInputs(af::span, range) = af::array(_inputs, (dim_t)count, _inputData.data() + _uploaded * _inputs);
+    _deviceTargets(af::span, range) = af::array(_outputs, (dim_t)count, _targetData.data() + _uploaded * _outputs);
+    _uploaded = samples;
+    uploadReplaced();
+}
+
+void Dataset::uploadReplaced() {
+    if (_dirty.empty()) {
+        return;
+    }
+    std::sort(_dirty.begin(), _dirty.end());
+    _dirty.erase(std::unique(_dirty.begin(), _dirty.end()), _dirty.end());
+
+    // All replaced samples are written with one scatter
+    std::vector<unsigned int> index(_dirty.begin(), _dirty.end());
+    std::vector<float> input;
+    std::vector<float> target;
+    for (size_t sample : _dirty) {
+        input.insert(input.end(), _inputData.begin() + (long)(sample * _inputs),
+                     _inputData.begin() + (long)((sample + 1) * _inputs));
+        target.insert(target.end(), _targetData.begin() + (long)(sample * _outputs),
+                      _targetData.begin() + (long)((sample + 1) * _outputs));
+    }
+
+    af::array columns((dim_t)index.size(), index.data());
+    _deviceInputs(af::span, columns) = af::array(_inputs, (dim_t)index.size(), input.data());
+    _deviceTargets(af::span, columns) = af::array(_outputs, (dim_t)index.size(), target.data());
+    _dirty.clear();
+}
+
+af::array Dataset::inputs() {
+    upload();
+    if (empty()) {
+        return af::array();
+    }
+    return _deviceInputs(af::span, af::seq((double)size()));
+}
+
+af::array Dataset::targets() {
+    upload();
+    if (empty()) {
+        return af::array();
+    }
+    return _deviceTargets(af::span, af::seq((double)size()));
+}
+
+size_t Dataset::begin() {
+    // Release the views of the last generation first, otherwise appending to the shared device memory copies it
+    _generationInputs = af::array();
+    _generationTargets = af::array();
+
+    // Changes of the dataset only apply to the next generation
+    _generationInputs = inputs();
+    _generationTargets = targets();
+    return size();
+}
+
+void Dataset::batch(size_t start, size_t count, af::array &inputs, af::array &targets) {
+    af::seq range((double)start, (double)(start + count - 1));
+    inputs = _generationInputs(af::span, range);
+    targets = _generationTargets(af::span, range);
+}
+
+void Dataset::gather(const af::array &indices, af::array &inputs, af::array &targets) {
+    inputs = af::lookup(_generationInputs, indices, 1);
+    targets = af::lookup(_generationTargets, indices, 1);
+}
@@ -0,0 +1,86 @@
+#ifndef KI_DATASET_H
+#define KI_DATASET_H
+
+#include <arrayfire.h>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cctype>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+#include "../Utility/Utility.h"
+#include "DataSource.h"
+
+// Samples kept in memory, e.g. the points drawn in the interface or a CSV file
+class Dataset : public DataSource {
+private:
+    int _inputs;
+    int _outputs;
+
+    // Samples are stored column by column: [inputs, samples] and [outputs, samples]
+    std::vector<float> _inputData;
+    std::vector<float> _targetData;
+
+    // Device copies of the inputs and targets with spare columns, only samples added since the last upload are copied
+    af::array _deviceInputs;
+    af::array _deviceTargets;
+    size_t _uploaded = 0;
+    std::vector<size_t> _dirty; // Uploaded samples replaced since
+
+    // Views of the samples of the current generation
+    af::array _generationInputs;
+    af::array _generationTargets;
+    uint64_t _version = 0; // Increases whenever the samples change
+    uint64_t _epoch = 0;   // The same, except for appended and replaced samples
+
+    // Samples replaced in the current epoch with their previous values, so results on them can be corrected
+    std::vector<size_t> _replacedIndices;
+    std::vector<float> _replacedInputs;
+    std::vector<float> _replacedTargets;
+
+    static constexpr size_t _minCapacity = 1024;
+
+    void upload();
+    void uploadReplaced();
+    void newEpoch();
+
+public:
+    Dataset(int inputs, int outputs);
+
+    // Every line holds the inputs followed by the class index, e.g. "x,y,label" for points
+    bool load(std::string path);
+    bool save(std::string path);
+
+    void add(std::vector<float> const &input, int label);
+    void add(std::vector<float> const &input, std::vector<float> const &target);
+    void append(const Dataset &other);
+    // Overwrites the samples at the indices with the samples of the other dataset, in order
+    void replace(const std::vector<size_t> &indices, const Dataset &samples);
+    // Replaces the samples but keeps the device memory for the next upload
+    void assign(Dataset &&other);
+    void clear();
+
+    [[nodiscard]] size_t size() const override { return _inputData.size() / _inputs; }
+    [[nodiscard]] int inputSize() const override { return _inputs; }
+    [[nodiscard]] int outputSize() const override { return _outputs; }
+
+    [[nodiscard]] uint64_t version() const { return _version; }
+    [[nodiscard]] uint64_t epoch() const override { return _epoch; }
+    [[nodiscard]] size_t replacements() const override { return _replacedIndices.size(); }
+    void replaced(size_t from, size_t limit, af::array &indices, af::array &inputs, af::array &targets) override;
+
+    // Device arrays of all samples, uploading the ones added since the last call
+    af::array inputs();
+    af::array targets();
+
+    size_t begin() override;
+    void batch(size_t start, size_t count, af::array &inputs, af::array &targets) override;
+    void gather(const af::array &indices, af::array &inputs, af::array &targets) override;
+};
+
+
+#endif //KI_DATASET_H
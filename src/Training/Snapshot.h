@@ -0,0 +1,29 @@
+#ifndef KI_SNAPSHOT_H
+#define KI_SNAPSHOT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../NeuralNetwork/NeuralNetwork.h"
+#include "Trainer.h"
+
+// Immutable state of the training published after every generation.
+// It is shared between threads, so it must never be changed after publishing.
+struct Snapshot {
+    uint64_t version = 0;
+    Trainer::Statistics statistics;
+
+    // Best network of the population (network 0 after breeding)
+    NeuralNetwork champion;
+
+    // Information about the whole population
+    int networks = 0;
+    size_t bytes = 0;
+
+    // Only computed while a viewer asks for it
+    bool hasSummary = false;
+    Trainer::Summary summary;
+};
+
+
+#endif //KI_SNAPSHOT_H
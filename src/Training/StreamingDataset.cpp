@@ -0,0 +1,350 @@
+#include "StreamingDataset.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+StreamingDataset::StreamingDataset(size_t chunkSize) : _chunkSize(std::max<size_t>(1, chunkSize)) {
+}
+
+StreamingDataset::~StreamingDataset() {
+    close();
+}
+
+bool StreamingDataset::open(const std::string &path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open file for reading: " << path << "\n";
+        return false;
+    }
+    _fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    _mappingSize = (size_t)fileSize.QuadPart;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        std::cerr << "Failed to map file: " << path << "\n";
+        close();
+        return false;
+    }
+    _mappingHandle = mapping;
+    _mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    _descriptor = ::open(path.c_str(), O_RDONLY);
+    if (_descriptor < 0) {
+        std::cerr << "Failed to open file for reading: " << path << "\n";
+        return false;
+    }
+
+    struct stat status{};
+    fstat(_descriptor, &status);
+    _mappingSize = (size_t)status.st_size;
+
+    void *mapping = mmap(nullptr, _mappingSize, PROT_READ, MAP_PRIVATE, _descriptor, 0);
+    _mapping = (mapping == MAP_FAILED) ? nullptr : mapping;
+    if (_mapping != nullptr) {
+        // The chunks are read front to back
+        madvise(_mapping, _mappingSize, MADV_SEQUENTIAL);
+    }
+#endif
+
+    if (_mapping == nullptr || _mappingSize < sizeof(Header)) {
+        std::cerr << "Failed to map file: " << path << "\n";
+        close();
+        return false;
+    }
+
+    std::memcpy(&_header, _mapping, sizeof(Header));
+    size_t columns = (size_t)_header.inputs + _header.outputs;
+    if (std::memcmp(_header.magic, "KIDS", 4) != 0 || _header.version != 1 ||
+        _mappingSize < sizeof(Header) + columns * _header.samples * sizeof(float)) {
+        std::cerr << "The file " << path << " is not a valid dataset!\n";
+        close();
+        return false;
+    }
+
+    _columns = reinterpret_cast<const float *>(static_cast<const char *>(_mapping) + sizeof(Header));
+    for (auto &chunk : _chunks) {
+        chunk.staging = static_cast<float *>(af::pinned(_chunkSize * columns, f32));
+        chunk.buffer = af::array((dim_t)(_chunkSize * columns), f32);
+    }
+    return true;
+}
+
+void StreamingDataset::close() {
+    for (auto &chunk : _chunks) {
+        if (chunk.staging != nullptr) {
+            af::freePinned(chunk.staging);
+        }
+        chunk = Chunk();
+    }
+
+    unmap();
+    _header = Header();
+    _columns = nullptr;
+    _epoch++;
+}
+
+void StreamingDataset::unmap() {
+#ifdef _WIN32
+    if (_mapping != nullptr) {
+        UnmapViewOfFile(_mapping);
+    }
+    if (_mappingHandle != nullptr) {
+        CloseHandle(_mappingHandle);
+    }
+    if (_fileHandle != nullptr) {
+        CloseHandle(_fileHandle);
+    }
+    _mappingHandle = nullptr;
+    _fileHandle = nullptr;
+#else
+    if (_mapping != nullptr) {
+        munmap(_mapping, _mappingSize);
+    }
+    if (_descriptor >= 0) {
+        ::close(_descriptor);
+    }
+    _descriptor = -1;
+#endif
+    _mapping = nullptr;
+    _mappingSize = 0;
+}
+
+void StreamingDataset::load(Chunk &chunk, size_t start, size_t count) {
+    int columns = (int)(_header.inputs + _header.outputs);
+
+    // Gather the rows of every column into the pinned buffer, this is where the pages are read from disk.
+    // The staging buffer of this chunk was last written before the other chunk was uploaded and evaluated.
+    for (int column = 0; column < columns; ++column) {
+        std::memcpy(chunk.staging + (size_t)column * count, _columns + (size_t)column * _header.samples + start,
+                    count * sizeof(float));
+    }
+
+    // The write is queued without waiting for it, the transpose runs after it on the device.
+    // [count, columns] on the host, [columns, count] on the device
+    size_t elements = count * (size_t)columns;
+    chunk.buffer.write(chunk.staging, elements * sizeof(float), afHost);
+    af::array data = af::moddims(chunk.buffer(af::seq((double)elements)), (dim_t)count, columns).T();
+
+    chunk.start = start;
+    chunk.count = count;
+    chunk.inputs = data(af::seq((double)_header.inputs), af::span);
+    chunk.targets = data(af::seq((double)_header.inputs, (double)(columns - 1)), af::span);
+}
+
+size_t StreamingDataset::begin() {
+    if (empty()) {
+        return 0;
+    }
+
+    // Usually prefetched at the end of the last generation
+    Chunk &first = (_chunks[1].start == 0 && !_chunks[1].inputs.isempty()) ? _chunks[1] : _chunks[0];
+    if (first.start != 0 || first.inputs.isempty()) {
+        load(first, 0, std::min(_chunkSize, size()));
+    }
+    return size();
+}
+
+void StreamingDataset::batch(size_t start, size_t count, af::array &inputs, af::array &targets) {
+    auto contains = [&](const Chunk &chunk) {
+        return !chunk.inputs.isempty() && start >= chunk.start && start + count <= chunk.start + chunk.count;
+    };
+
+    Chunk *chunk = contains(_chunks[0]) ? &_chunks[0] : (contains(_chunks[1]) ? &_chunks[1] : nullptr);
+    if (chunk == nullptr) {
+        // Not prefetched, e.g. batches that do not line up with the chunks
+        chunk = &_chunks[0];
+        load(*chunk, start, std::max(count, std::min(_chunkSize, size() - start)));
+    }
+
+    af::seq range((double)(start - chunk->start), (double)(start - chunk->start + count - 1));
+    inputs = chunk->inputs(af::span, range);
+    targets = chunk->targets(af::span, range);
+
+    // Once the chunk is used up, the next one is gathered and written into the other buffers. The device still works
+    // on the batches queued before, so reading from disk and the upload overlap with their evaluation.
+    size_t end = start + count;
+    if (end == chunk->start + chunk->count) {
+        size_t next = (end >= size()) ? 0 : end; // The next generation starts at the front again
+        Chunk &other = (chunk == &_chunks[0]) ? _chunks[1] : _chunks[0];
+        if (other.start != next || other.inputs.isempty()) {
+            if (next != chunk->start) {
+                load(other, next, std::min(_chunkSize, size() - next));
+            }
+        }
+    }
+}
+
+void StreamingDataset::gather(const af::array &indices, af::array &inputs, af::array &targets) {
+    std::vector<unsigned int> rows(indices.elements());
+    indices.as(u32).host(rows.data());
+
+    int columns = (int)(_header.inputs + _header.outputs);
+    std::vector<af::array> parts;
+
+    // The rows are read from the mapped file in pieces of a chunk. The staging buffers of the chunks may still be
+    // uploading, so the pieces are gathered into their own buffer and copied synchronously.
+    std::vector<float> piece(std::min(_chunkSize, rows.size()) * columns);
+    for (size_t start = 0; start < rows.size(); start += _chunkSize) {
+        size_t count = std::min(_chunkSize, rows.size() - start);
+        for (int column = 0; column < columns; ++column) {
+            const float *source = _columns + (size_t)column * _header.samples;
+            float *destination = piece.data() + (size_t)column * count;
+            for (size_t i = 0; i < count; ++i) {
+                destination[i] = source[rows[start + i]];
+            }
+        }
+        parts.push_back(af::array((dim_t)count, columns, piece.data()).T());
+    }
+
+    af::array data = parts.empty() ? af::array() : parts[0];
+    for (size_t i = 1; i < parts.size(); ++i) {
+        data = af::join(1, data, parts[i]);
+    }
+
+    if (data.isempty()) {
+        inputs = af::array();
+        targets = af::array();
+        return;
+    }
+    inputs = data(af::seq((double)_header.inputs), af::span);
+    targets = data(af::seq((double)_header.inputs, (double)(columns - 1)), af::span);
+}
+
+bool StreamingDataset::import(const std::string &csvPath, const std::string &path, int inputs, int outputs) {
+    std::ifstream csv(csvPath);
+    if (!csv.is_open()) {
+        std::cerr << "Failed to open file for reading: " << csvPath << "\n";
+        return false;
+    }
+
+    // Returns 1 for a sample, 0 for a line to skip and -1 for an invalid line
+    auto parse = [&](const std::string &line, int lineNumber, std::vector<float> &values) {
+        if (line.empty() || line[0] == '#' || (lineNumber == 1 && std::isalpha((unsigned char)line[0]))) {
+            return 0;
+        }
+
+        values.clear();
+        std::stringstream stream(line);
+        std::string item;
+        try {
+            while (std::getline(stream, item, ',')) {
+                values.push_back(std::stof(item));
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Invalid value in line " << lineNumber << " of " << csvPath << "\n";
+            return -1;
+        }
+
+        if (values.size() != inputs + 1) {
+            std::cerr << "Line " << lineNumber << " of " << csvPath << " must contain " << inputs
+                      << " inputs and a label!\n";
+            return -1;
+        }
+
+        // Same check as Dataset::load, the label has to be a whole number in range
+        float label = values.back();
+        if (label != std::floor(label) || label < 0 || label >= (float)outputs) {
+            std::cerr << "Invalid label in line " << lineNumber << " of " << csvPath << ", it must be between 0 and "
+                      << outputs - 1 << "!\n";
+            return -1;
+        }
+        return 1;
+    };
+
+    // The columns are written in blocks, so the number of samples is needed first
+    std::string line;
+    std::vector<float> values;
+    Header header;
+    header.inputs = inputs;
+    header.outputs = outputs;
+
+    int lineNumber = 0;
+    while (std::getline(csv, line)) {
+        int result = parse(line, ++lineNumber, values);
+        if (result < 0) {
+            return false;
+        }
+        header.samples += result;
+    }
+
+    // The file is written next to the target and only renamed once it is complete, so a failed import never
+    // leaves a partial dataset behind
+    std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << temporary << "\n";
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+
+    const size_t blockSize = 1 << 16;
+    int columns = inputs + outputs;
+    std::vector<float> block((size_t)columns * blockSize);
+    size_t blockStart = 0, rows = 0;
+
+    auto flush = [&]() {
+        for (int column = 0; column < columns; ++column) {
+            file.seekp((std::streamoff)(sizeof(Header) + ((size_t)column * header.samples + blockStart) * sizeof(float)));
+            file.write(reinterpret_cast<const char *>(block.data() + (size_t)column * blockSize),
+                       (std::streamsize)(rows * sizeof(float)));
+        }
+        blockStart += rows;
+        rows = 0;
+    };
+
+    csv.clear();
+    csv.seekg(0);
+    lineNumber = 0;
+    size_t written = 0;
+    while (std::getline(csv, line)) {
+        int result = parse(line, ++lineNumber, values);
+        if (result < 0) {
+            break;
+        }
+        if (result == 0) {
+            continue;
+        }
+        written++;
+
+        int label = (int)values.back();
+        for (int column = 0; column < columns; ++column) {
+            float value = (column < inputs) ? values[column] : (column - inputs == label ? 1.0f : 0.0f);
+            block[(size_t)column * blockSize + rows] = value;
+        }
+
+        if (++rows == blockSize) {
+            flush();
+        }
+    }
+    flush();
+    file.close();
+
+    // The CSV file may have changed between the passes
+    if (written != header.samples || !file) {
+        std::cerr << "Failed to convert " << csvPath << " into " << path << "\n";
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to rename " << temporary << " to " << path << "\n";
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#ifndef KI_STREAMINGDATASET_H
+#define KI_STREAMINGDATASET_H
+
+#include <arrayfire.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cctype>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "DataSource.h"
+
+// Samples in a memory-mapped binary file, streamed to the device in chunks of a fixed size. Only two chunks are on
+// the device at a time, so the size of the dataset is limited by the disk and not by the device memory.
+//
+// The file starts with a header, followed by the columns: every input and then every target as `samples` floats.
+class StreamingDataset : public DataSource {
+public:
+    struct Header {
+        char magic[4] = {'K', 'I', 'D', 'S'};
+        uint32_t version = 1;
+        uint32_t inputs = 0;
+        uint32_t outputs = 0;
+        uint64_t samples = 0;
+    };
+
+private:
+    Header _header;
+    size_t _chunkSize;
+
+    // Mapped file, the handles are only used on Windows
+    const float *_columns = nullptr;
+    void *_mapping = nullptr;
+    size_t _mappingSize = 0;
+    int _descriptor = -1;
+    void *_fileHandle = nullptr;
+    void *_mappingHandle = nullptr;
+
+    // Double buffering: the next chunk is gathered and uploaded while the device still evaluates the current one.
+    // Every chunk has its own pinned staging buffer and device buffer, so the upload is written asynchronously and
+    // the gathering of the next chunk never waits for it.
+    struct Chunk {
+        size_t start = 0;
+        size_t count = 0;
+        af::array inputs;
+        af::array targets;
+        float *staging = nullptr; // Pinned host memory, [count, inputs + outputs]
+        af::array buffer;         // Device memory the staging buffer is written to, [chunkSize * (inputs + outputs)]
+    };
+    Chunk _chunks[2];
+    int _current = 0;
+    uint64_t _epoch = 0;
+
+    void load(Chunk &chunk, size_t start, size_t count);
+    void unmap();
+
+public:
+    explicit StreamingDataset(size_t chunkSize = 1 << 16);
+    ~StreamingDataset() override;
+
+    StreamingDataset(const StreamingDataset &) = delete;
+    StreamingDataset &operator=(const StreamingDataset &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    // Converts a CSV file with the inputs followed by the class index per line, like Dataset::load
+    static bool import(const std::string &csvPath, const std::string &path, int inputs, int outputs);
+
+    [[nodiscard]] size_t size() const override { return (size_t)_header.samples; }
+    [[nodiscard]] int inputSize() const override { return (int)_header.inputs; }
+    [[nodiscard]] int outputSize() const override { return (int)_header.outputs; }
+    [[nodiscard]] uint64_t epoch() const override { return _epoch; }
+    [[nodiscard]] size_t maxBatch() const override { return _chunkSize; }
+
+    size_t begin() override;
+    void batch(size_t start, size_t count, af::array &inputs, af::array &targets) override;
+    void gather(const af::array &indices, af::array &inputs, af::array &targets) override;
+};
+
+
+#endif //KI_STREAMINGDATASET_H
@@ -0,0 +1,418 @@
+#include "Trainer.h"
+
+Trainer::Trainer(NeuralNetwork &network, DataSource &source, int winners, float mutationMin, float mutationMax, bool uniform) :
+_network(network), _source(source), _winners(winners), _mutationMin(mutationMin), _mutationMax(mutationMax), _uniform(uniform) {
+}
+
+Trainer::Statistics Trainer::step() {
+    evaluate(remaining());
+    return breed();
+}
+
+void Trainer::racing(bool enabled, float keep, int margin, size_t start) {
+    _racing = enabled;
+    _racingKeep = std::clamp(keep, 0.01f, 1.0f);
+    _racingMargin = std::max(1, margin);
+    _racingStart = std::max<size_t>(1, start);
+}
+
+void Trainer::miniBatch(size_t samples, float smoothing) {
+    _miniBatch = samples;
+    _smoothing = std::clamp(smoothing, 0.0f, 0.99f);
+}
+
+void Trainer::begin() {
+    _samples = _source.begin();
+    _generationEpoch = _source.epoch();
+    _generationReplacements = _source.replacements();
+
+    // Errors on samples that were replaced or removed say nothing about the new ones
+    if (_carriedEpoch != _generationEpoch) {
+        _carriedError = af::array();
+    }
+
+    if (_miniBatch > 0 && _miniBatch < _samples) {
+        // The first indices of a random permutation, drawn on the device
+        af::array keys, order;
+        af::sort(keys, order, af::randu((dim_t)_samples));
+        _source.gather(order(af::seq((double)_miniBatch)), _batchInputs, _batchTargets);
+        _samples = _miniBatch;
+    } else {
+        _batchInputs = af::array();
+        _batchTargets = af::array();
+    }
+    _error = af::constant(0.0f, _network.networks());
+    _evaluated = 0;
+    _evaluations = 0;
+    _seconds = 0.0f;
+    _started = true;
+
+    // The cache is only valid for the same winners and if the source was at most appended to or replaced in place
+    _reusing = _caching && !_racing && _batchInputs.isempty() && !_cached.isempty() &&
+               _cached.elements() == _network.networks() && _cacheEpoch == _generationEpoch &&
+               _cacheVersion == _network.version() && _cachedSamples <= _samples;
+    _compact = _reusing || (_deduplicate && !_racing);
+    _duplicates = 0.0f;
+    if (_compact) {
+        if (_reusing) {
+            _error = af::select(_cached, _cachedError, 0.0);
+            _changed = af::where(!_cached);
+            _unchanged = af::where(_cached);
+            _unchangedNetworks = _network.select(_unchanged);
+
+            // Samples replaced in place since: the errors on their previous values are swapped for the new ones
+            if (_generationReplacements > _cacheReplacements) {
+                af::array indices, previousInputs, previousTargets;
+                _source.replaced(_cacheReplacements, _cachedSamples, indices, previousInputs, previousTargets);
+                if (!indices.isempty()) {
+                    af::array inputs, targets;
+                    _source.gather(indices, inputs, targets);
+                    af::array current = _unchangedNetworks.error(inputs, targets);
+                    af::array previous = _unchangedNetworks.error(previousInputs, previousTargets);
+                    _error(_unchanged) += current - previous;
+                    _evaluations += 2.0 * (double)_unchanged.elements() * (double)indices.elements();
+                }
+            }
+        } else {
+            _changed = af::range(af::dim4(_network.networks()), 0, u32);
+            _unchanged = af::array();
+            _unchangedNetworks = NeuralNetwork();
+        }
+
+        _scatter = af::array();
+        if (_changed.isempty()) {
+            // Without children only the appended samples are left
+            _changedNetworks = NeuralNetwork();
+            _evaluated = _cachedSamples;
+        } else if (_deduplicate) {
+            deduplicate();
+        } else {
+            _changedNetworks = _network.select(_changed);
+        }
+    }
+
+    if (_racing) {
+        // Every network starts in the race
+        _survivors = af::range(af::dim4(_network.networks()), 0, u32);
+        _contestants = _network;
+        _counts = af::constant(0.0f, _network.networks());
+        _roundSamples = std::min(_racingStart, _samples);
+        _roundEnd = _roundSamples;
+        _leaders = af::array();
+    }
+    _decided = false;
+}
+
+void Trainer::race() {
+    auto survivors = (int)_survivors.elements();
+    int keep = std::max((int)((float)survivors * _racingKeep), _racingMargin * _winners);
+
+    // All survivors were evaluated on the same samples, so their errors can be compared directly
+    af::array sorted, order;
+    af::sort(sorted, order, _error(_survivors));
+
+    // The race is decided once more samples no longer change who wins
+    if (survivors > _winners) {
+        af::array leaders = af::sort(_survivors(order(af::seq(_winners))));
+        bool stable = !_leaders.isempty() && af::allTrue<bool>(leaders == _leaders);
+        _leaders = leaders;
+        if (stable) {
+            _decided = true;
+            return;
+        }
+    }
+
+    if (keep < survivors) {
+        _survivors = _survivors(order(af::seq(keep)));
+        _contestants = _network.select(_survivors);
+
+        // Successive halving: fewer networks, but twice the samples in the next round
+        _roundSamples *= 2;
+        _roundEnd = std::min(_evaluated + _roundSamples, _samples);
+    } else {
+        // Close to the winners the race is over, the rest is evaluated on all remaining samples
+        _roundEnd = _samples;
+    }
+}
+
+void Trainer::deduplicate() {
+    // Equal fingerprints are next to each other after sorting
+    af::array keys, order;
+    af::sort(keys, order, af::lookup(_network.fingerprint(_quantum), _changed));
+    dim_t count = keys.elements();
+
+    // The first network of every run of equal fingerprints represents the group
+    af::array first = af::constant(1, count, b8);
+    if (count > 1) {
+        af::seq next(1, (double)count - 1);
+        af::seq previous(0, (double)count - 2);
+        first(next) = keys(next) != keys(previous);
+    }
+    af::array representatives = af::lookup(order, af::where(first));
+
+    // Group of every changed network, the groups are numbered like the representatives
+    _scatter = af::constant(0, count, u32);
+    _scatter(order) = af::accum(first.as(u32)) - 1u;
+
+    _changedNetworks = _network.select(af::lookup(_changed, representatives));
+    _duplicates = 1.0f - (float)representatives.elements() / (float)count;
+}
+
+size_t Trainer::remaining() const {
+    if (!_started) {
+        return _source.size();
+    }
+    return _decided ? 0 : _samples - _evaluated;
+}
+
+size_t Trainer::evaluate(size_t maxSamples) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (!_started) {
+        // Nothing to learn yet
+        if (_source.empty()) {
+            return 0;
+        }
+        begin();
+    }
+
+    size_t count = std::min(maxSamples, remaining());
+    if (count == 0) {
+        return 0;
+    }
+
+    // The errors are accumulated over the batches of the source
+    size_t done = 0;
+    while (done < count) {
+        size_t batch = std::min(count - done, _source.maxBatch());
+        if (_racing) {
+            batch = std::min(batch, _roundEnd - _evaluated);
+        }
+        if (_reusing && _evaluated < _cachedSamples) {
+            batch = std::min(batch, _cachedSamples - _evaluated);
+        }
+
+        af::array inputs, targets;
+        if (_batchInputs.isempty()) {
+            _source.batch(_evaluated, batch, inputs, targets);
+        } else {
+            af::seq range((double)_evaluated, (double)(_evaluated + batch - 1));
+            inputs = _batchInputs(af::span, range);
+            targets = _batchTargets(af::span, range);
+        }
+
+        if (_racing) {
+            // Only the networks still in the race are evaluated
+            _error(_survivors) += _contestants.error(inputs, targets);
+            _counts(_survivors) += (float)batch;
+            _evaluations += (double)_survivors.elements() * (double)batch;
+        } else if (_compact) {
+            if (!_changed.isempty()) {
+                af::array error = _changedNetworks.error(inputs, targets);
+                if (!_scatter.isempty()) {
+                    // Duplicates get the error of their representative
+                    error = af::lookup(error, _scatter);
+                }
+                _error(_changed) += error;
+                _evaluations += (double)_changedNetworks.networks() * (double)batch;
+            }
+
+            // The cached networks already know their error on the samples before _cachedSamples
+            if (!_unchanged.isempty() && _evaluated >= _cachedSamples) {
+                _error(_unchanged) += _unchangedNetworks.error(inputs, targets);
+                _evaluations += (double)_unchanged.elements() * (double)batch;
+            }
+        } else {
+            _error += _network.error(inputs, targets);
+            _evaluations += (double)_network.networks() * (double)batch;
+        }
+        _evaluated += batch;
+        done += batch;
+
+        if (_racing && _evaluated == _roundEnd && _evaluated < _samples) {
+            race();
+            if (_decided) {
+                break;
+            }
+        }
+    }
+
+    _seconds += std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+    return done;
+}
+
+Trainer::Statistics Trainer::breed() {
+    if (!_started || remaining() > 0) {
+        return _statistics;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Lower error means higher fitness
+    af::array fitnessArray = -_error;
+    _lastError = _error;
+
+    // The winners carry a moving average of their error per sample, so a lucky mini-batch weighs less
+    // Only mini-batches are noisy, on all samples the error of the current generation is exact
+    bool smoothing = _smoothing > 0.0f && !_batchInputs.isempty();
+    af::array smoothedError;
+    if (smoothing) {
+        // A decided race stopped early, so the errors are normalized by the samples every network saw
+        smoothedError = _racing ? _error / af::max(_counts, 1.0f) : _error / (float)_samples;
+        if (!_carriedError.isempty() && _carriedError.elements() <= _network.networks()) {
+            af::seq elites((double)_carriedError.elements());
+            af::array current = smoothedError(elites);
+            smoothedError(elites) = _smoothing * _carriedError + (1.0f - _smoothing) * current;
+        }
+        fitnessArray = -smoothedError;
+    }
+
+    if (_racing) {
+        // Networks that dropped out of the race can never win, their error is extrapolated for the statistics
+        af::array finished = af::constant(0, _network.networks(), b8);
+        finished(_survivors) = 1;
+        fitnessArray = af::select(finished, fitnessArray, -std::numeric_limits<double>::infinity());
+        _lastError = _error * (float)_samples / af::max(_counts, 1.0f);
+    }
+
+    std::vector<float> fitness = Utility::arrayToVector(fitnessArray);
+    int best = Utility::find_top_n(fitness, 1)[0];
+    float meanError = af::mean<float>(_lastError);
+    af::array bestError = _lastError(best);
+
+    std::vector<int> selected = _network.breed(fitness, _winners, _mutationMin, _mutationMax, _uniform);
+    _started = false;
+
+    float mutation = 0.0f;
+    af::array strength = _network.mutationStrength();
+    if (!strength.isempty() && !selected.empty()) {
+        af::array winners = strength(af::seq((double)selected.size()));
+        mutation = af::mean<float>(winners);
+    }
+
+    // The winners are networks 0 to winners - 1 in the next generation
+    if (_caching && !_racing && _batchInputs.isempty() && !selected.empty()) {
+        af::seq elites((double)selected.size());
+        _cachedError = af::constant(0.0f, _network.networks());
+        _cachedError(elites) = af::lookup(_error, af::array((dim_t)selected.size(), selected.data()).as(u32));
+        _cached = af::constant(0, _network.networks(), b8);
+        _cached(elites) = 1;
+        _cachedSamples = _samples;
+        _cacheEpoch = _generationEpoch;
+        _cacheReplacements = _generationReplacements;
+        _cacheVersion = _network.version();
+    } else {
+        _cached = af::array();
+    }
+    _changedNetworks = NeuralNetwork();
+    _unchangedNetworks = NeuralNetwork();
+
+    if (smoothing && !selected.empty()) {
+        _carriedError = af::lookup(smoothedError, af::array((dim_t)selected.size(), selected.data()).as(u32));
+        _carriedEpoch = _generationEpoch;
+    } else {
+        _carriedError = af::array();
+    }
+
+    _seconds += std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+
+    _statistics.generation++;
+    _statistics.best = best;
+    _statistics.bestError = bestError.scalar<float>();
+    _statistics.meanError = meanError;
+    _statistics.seconds = _seconds;
+    _statistics.evaluations = _evaluations;
+    _statistics.duplicates = _duplicates;
+    _statistics.mutation = mutation;
+
+    return _statistics;
+}
+
+Trainer::Summary Trainer::summarize(int bins, int maxCells) {
+    Summary summary;
+    if (_lastError.isempty()) {
+        return summary;
+    }
+
+    int networks = _network.networks();
+    int winners = std::min(_winners, networks);
+
+    // Every part is flattened and joined, so the whole summary is copied with a single transfer
+    std::vector<af::array> parts;
+
+    // Fitness histogram over the error range of the generation
+    af::array minError = af::min(_lastError);
+    af::array maxError = af::max(_lastError);
+    af::array normalized = (_lastError - af::tile(minError, networks)) /
+                           af::tile(maxError - minError + 1e-12f, networks);
+    parts.push_back(af::histogram(normalized, bins, 0.0, 1.0).as(f32));
+    parts.push_back(minError);
+    parts.push_back(maxError);
+
+    // The winners have the lowest errors
+    af::array sorted = af::sort(_lastError);
+    parts.push_back(af::mean(sorted(af::seq(winners)), 0));
+
+    // Standard deviation of every parameter over dimension 2 (the networks)
+    auto deviation = [](const af::array &values) {
+        af::array mean = af::mean(values, 2);
+        return af::sqrt(af::max(af::mean(values * values, 2) - mean * mean, 0.0f));
+    };
+
+    af::array diversity = af::constant(0.0f, 1);
+    af::array eliteDiversity = af::constant(0.0f, 1);
+    size_t parameters = 0;
+    std::vector<af::array> layerParts;
+
+    for (int layer = 0; layer < _network.weights().size(); ++layer) {
+        const af::array &weights = _network.weights(layer);
+        const af::array &biases = _network.biases(layer);
+
+        // After breeding the winners are the first networks
+        af::seq elites(winners);
+        af::array weightDeviation = deviation(weights);
+        diversity += af::sum(af::flat(weightDeviation)) + af::sum(af::flat(deviation(biases)));
+        eliteDiversity += af::sum(af::flat(deviation(weights(af::span, af::span, elites)))) +
+                          af::sum(af::flat(deviation(biases(af::span, af::span, elites))));
+        parameters += weights.dims(0) * weights.dims(1) + biases.dims(0);
+
+        // Large layers are downsampled before the transfer
+        int group = (int)std::max<dim_t>(1, (std::max(weights.dims(0), weights.dims(1)) + maxCells - 1) / maxCells);
+        af::array mean = Utility::blockReduce(af::mean(weights, 2), group, group);
+        af::array spread = Utility::blockReduce(weightDeviation, group, group);
+
+        summary.shapes.emplace_back((int)mean.dims(0), (int)mean.dims(1));
+        layerParts.push_back(af::flat(mean));
+        layerParts.push_back(af::flat(spread));
+    }
+
+    parts.push_back(diversity);
+    parts.push_back(eliteDiversity);
+    parts.insert(parts.end(), layerParts.begin(), layerParts.end());
+
+    af::array all = af::flat(parts[0]);
+    for (size_t i = 1; i < parts.size(); ++i) {
+        all = af::join(0, all, af::flat(parts[i]));
+    }
+    std::vector<float> host = Utility::arrayToVector(all);
+
+    // Unpack in the same order
+    size_t offset = 0;
+    summary.histogram.assign(host.begin(), host.begin() + bins);
+    offset += bins;
+    summary.minError = host[offset++];
+    summary.maxError = host[offset++];
+    summary.eliteError = host[offset++];
+    summary.diversity = host[offset++] / (float)parameters;
+    summary.eliteDiversity = host[offset++] / (float)parameters;
+
+    for (auto &shape : summary.shapes) {
+        size_t cells = (size_t)shape.first * shape.second;
+        summary.means.emplace_back(host.begin() + (long)offset, host.begin() + (long)(offset + cells));
+        offset += cells;
+        summary.deviations.emplace_back(host.begin() + (long)offset, host.begin() + (long)(offset + cells));
+        offset += cells;
+    }
+
+    return summary;
+}
@@ -0,0 +1,148 @@
+#ifndef KI_TRAINER_H
+#define KI_TRAINER_H
+
+#include <arrayfire.h>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+#include "../NeuralNetwork/NeuralNetwork.h"
+#include "../Utility/Utility.h"
+#include "DataSource.h"
+
+class Trainer {
+public:
+    struct Statistics {
+        int generation = 0;
+        int best = -1;          // Index of the best network before breeding, it is network 0 afterwards
+        float bestError = 0.0f;
+        float meanError = 0.0f;
+        float seconds = 0.0f;   // Computation time of the last generation
+        double evaluations = 0; // Network evaluations on single samples of the last generation
+        float duplicates = 0.0f;  // Part of the evaluated networks that shared the genome of another one
+        float mutation = 0.0f;    // Mean self-adaptive mutation strength of the winners, 0 without self-adaptation
+    };
+
+    // Population overview, computed on the device
+    struct Summary {
+        std::vector<float> histogram;       // Number of networks per error bin
+        float minError = 0.0f;
+        float maxError = 0.0f;
+        float eliteError = 0.0f;            // Mean error of the winners
+        float diversity = 0.0f;             // Mean standard deviation of the parameters over the population
+        float eliteDiversity = 0.0f;        // The same for the winners only
+
+        // Mean and standard deviation of every connection over the population, downsampled for large layers
+        std::vector<std::vector<float>> means;
+        std::vector<std::vector<float>> deviations;
+        std::vector<std::pair<int, int>> shapes;
+    };
+
+private:
+    NeuralNetwork &_network;
+    DataSource &_source;
+
+    // Breeding parameters
+    int _winners;
+    float _mutationMin;
+    float _mutationMax;
+    bool _uniform;
+
+    Statistics _statistics;
+
+    // Progress of the current generation, the samples are fixed when it starts
+    bool _started = false;
+    size_t _samples = 0;
+    double _evaluations = 0;
+
+    // Mini-batches: every generation is evaluated on a random subset of the samples, drawn without replacement
+    size_t _miniBatch = 0;          // 0 uses all samples
+    float _smoothing = 0.0f;        // Weight of the history in the moving average of the winners' errors
+    af::array _batchInputs;
+    af::array _batchTargets;
+    af::array _carriedError;        // Smoothed error per sample of the winners, networks 0 to winners - 1 after breeding
+    uint64_t _carriedEpoch = 0;     // Epoch of the source the smoothed errors belong to
+
+    // Racing: the population is evaluated on growing parts of the samples and after every round only the best part
+    // stays in the race, as long as clearly more networks than winners are left. The race is decided as soon as the
+    // top winners are the same in two rounds in a row, then the remaining samples are skipped.
+    bool _racing = false;
+    float _racingKeep = 0.5f;       // Part of the networks kept after every round
+    int _racingMargin = 4;          // The survivors never drop below this many times the winners
+    size_t _racingStart = 64;       // Samples of the first round, doubled every round
+    af::array _survivors;           // Indices of the networks still in the race
+    NeuralNetwork _contestants;     // Copies of the surviving networks
+    af::array _counts;              // Samples every network was evaluated on
+    size_t _roundSamples = 0;
+    size_t _roundEnd = 0;
+    af::array _leaders;             // Sorted indices of the top winners after the last round
+    bool _decided = false;          // The leaders did not change, the generation needs no more samples
+
+    // Fitness cache: the winners are copied unchanged into the next generation, so their errors are kept and they are
+    // only evaluated on the samples appended or replaced since. Used when a generation sees all samples and nobody
+    // races.
+    bool _caching = true;
+    af::array _cachedError;         // Error sums of the winners at their new positions
+    af::array _cached;              // Networks whose error is cached (b8)
+    size_t _cachedSamples = 0;      // Samples the cached errors cover
+    uint64_t _cacheEpoch = 0;       // Epoch of the source the errors were computed on
+    uint64_t _cacheVersion = 0;     // Version of the network after breeding
+    size_t _cacheReplacements = 0;  // Samples of the source replaced in place before the errors were computed
+    uint64_t _generationEpoch = 0;
+    size_t _generationReplacements = 0;
+    bool _reusing = false;          // The current generation started from the cache
+
+    // Duplicates: networks with the same fingerprint are evaluated once and share the error
+    bool _deduplicate = false;
+    float _quantum = 1e-6f;         // Parameters closer than this count as equal
+    float _duplicates = 0.0f;
+    af::array _scatter;             // Representative of every changed network
+
+    // Compact evaluation with the cache or duplicates: only the selected networks are evaluated
+    bool _compact = false;
+    af::array _changed;             // Indices of the networks evaluated on all samples
+    af::array _unchanged;           // Indices of the cached networks
+    NeuralNetwork _changedNetworks;
+    NeuralNetwork _unchangedNetworks;
+
+    af::array _error;
+    af::array _lastError; // Errors of the last finished generation
+    size_t _evaluated = 0;
+    float _seconds = 0.0f;
+
+    void begin();
+    void race();
+    void deduplicate();
+
+public:
+    Trainer(NeuralNetwork &network, DataSource &source, int winners = 500, float mutationMin = -0.05f,
+            float mutationMax = 0.05f, bool uniform = true);
+
+    // Getter and setter
+    [[nodiscard]] NeuralNetwork &network() { return _network; }
+    [[nodiscard]] DataSource &source() { return _source; }
+    [[nodiscard]] Statistics &statistics() { return _statistics; }
+    [[nodiscard]] int winners() const { return _winners; }
+    void winners(int value) { _winners = value; }
+    void mutation(float min, float max) { _mutationMin = min; _mutationMax = max; }
+    void miniBatch(size_t samples, float smoothing = 0.0f);
+    void racing(bool enabled, float keep = 0.5f, int margin = 4, size_t start = 64);
+    void caching(bool enabled) { _caching = enabled; _cached = af::array(); }
+    void deduplicate(bool enabled, float quantum = 1e-6f) { _deduplicate = enabled; _quantum = quantum; }
+
+    // Evaluates the population on the dataset and breeds the next generation
+    Statistics step();
+
+    // A generation can also be split: evaluate the samples in parts, then breed
+    size_t evaluate(size_t maxSamples);
+    Statistics breed();
+    [[nodiscard]] size_t remaining() const;
+    [[nodiscard]] bool evaluated() const { return _started && remaining() == 0; }
+
+    // Reductions over the population, only the summary is copied to the host
+    Summary summarize(int bins = 32, int maxCells = 32);
+};
+
+
+#endif //KI_TRAINER_H
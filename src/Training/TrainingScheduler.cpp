@@ -0,0 +1,67 @@
+#include "TrainingScheduler.h"
+
+TrainingScheduler::TrainingScheduler(Trainer &trainer, float budget) : _trainer(trainer), _budget(budget) {
+}
+
+double TrainingScheduler::average(double current, double measured, double smoothing) {
+    return (current <= 0.0) ? measured : current + smoothing * (measured - current);
+}
+
+int TrainingScheduler::run() {
+    using clock = std::chrono::high_resolution_clock;
+    auto start = clock::now();
+    int generations = 0;
+    bool worked = false;
+
+    while (true) {
+        double remainingTime = _budget - std::chrono::duration<double>(clock::now() - start).count();
+        if (remainingTime <= 0.0) {
+            break;
+        }
+
+        // A fully evaluated generation is only bred if the breed fits, otherwise it starts the next call.
+        // A breed that never fits into the budget still runs at the start of a call, so training goes on.
+        if (_trainer.evaluated()) {
+            if (worked && _breedSeconds > remainingTime) {
+                break;
+            }
+            auto breedStart = clock::now();
+            _trainer.breed();
+            af::sync();
+            _breedSeconds = average(_breedSeconds, std::chrono::duration<double>(clock::now() - breedStart).count(), _smoothing);
+            generations++;
+            worked = true;
+            continue;
+        }
+
+        size_t remainingSamples = _trainer.remaining();
+        if (remainingSamples == 0) {
+            break;
+        }
+
+        // Decide how many samples fit into the remaining time
+        size_t samples;
+        if (_secondsPerSample <= 0.0) {
+            samples = std::min(remainingSamples, _probeSamples);
+        } else if (remainingSamples * _secondsPerSample + _breedSeconds <= remainingTime) {
+            samples = remainingSamples;
+        } else {
+            // Only a part of the generation fits, the rest is evaluated during the next calls
+            samples = (size_t)std::max(1.0, remainingTime / _secondsPerSample);
+            samples = std::min(samples, remainingSamples);
+        }
+
+        auto evaluationStart = clock::now();
+        size_t evaluated = _trainer.evaluate(samples);
+        af::sync();
+        double evaluationTime = std::chrono::duration<double>(clock::now() - evaluationStart).count();
+
+        if (evaluated == 0) {
+            break;
+        }
+        _secondsPerSample = average(_secondsPerSample, evaluationTime / (double)evaluated, _smoothing);
+        worked = true;
+    }
+
+    return generations;
+}
@@ -0,0 +1,41 @@
+#ifndef KI_TRAININGSCHEDULER_H
+#define KI_TRAININGSCHEDULER_H
+
+#include <arrayfire.h>
+#include <chrono>
+#include <algorithm>
+
+#include "Trainer.h"
+
+// Runs as much training as fits into a time budget, e.g. 8 ms of a 16 ms frame.
+// The cost of a generation is measured while training, so growing datasets are handled
+// automatically. A generation that does not fit is evaluated in parts over several calls,
+// and its breed is moved to the next call if the estimated breed time no longer fits.
+class TrainingScheduler {
+private:
+    Trainer &_trainer;
+    float _budget; // Seconds per call of run()
+
+    // Measured costs (exponential moving averages)
+    double _secondsPerSample = 0.0; // Evaluating one sample on the whole population
+    double _breedSeconds = 0.0;
+    double _smoothing = 0.25;
+
+    // Used until the first measurement exists
+    size_t _probeSamples = 16;
+
+    static double average(double current, double measured, double smoothing);
+
+public:
+    explicit TrainingScheduler(Trainer &trainer, float budget = 0.008f);
+
+    // Getter and setter
+    [[nodiscard]] float budget() const { return _budget; }
+    void budget(float value) { _budget = value; }
+
+    // Returns the number of finished generations
+    int run();
+};
+
+
+#endif //KI_TRAININGSCHEDULER_H
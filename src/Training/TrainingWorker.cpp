@@ -0,0 +1,165 @@
+#include "TrainingWorker.h"
+
+TrainingWorker::TrainingWorker(Trainer &trainer, Dataset &dataset, float frameBudget) :
+_trainer(trainer), _dataset(dataset), _scheduler(trainer, frameBudget) {
+    // The device is selected per thread, the worker uses the one of the creating thread
+    _device = af::getDevice();
+
+    // Readers always get a valid snapshot, even before the first generation
+    publish();
+}
+
+TrainingWorker::~TrainingWorker() {
+    stop();
+}
+
+void TrainingWorker::start() {
+    if (_running) {
+        return;
+    }
+
+    _running = true;
+    _thread = std::thread(&TrainingWorker::run, this);
+}
+
+void TrainingWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_datasetMutex);
+        _running = false;
+    }
+    _datasetChanged.notify_all();
+
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void TrainingWorker::submit(Dataset dataset) {
+    {
+        std::lock_guard<std::mutex> lock(_datasetMutex);
+        _pendingDataset = std::move(dataset);
+        _pendingSamples.reset();
+        _pendingIndices.clear();
+        _pendingReplacements.reset();
+    }
+    _datasetChanged.notify_all();
+}
+
+void TrainingWorker::append(Dataset samples) {
+    {
+        std::lock_guard<std::mutex> lock(_datasetMutex);
+        if (_pendingDataset.has_value()) {
+            _pendingDataset->append(samples);
+        } else if (_pendingSamples.has_value()) {
+            _pendingSamples->append(samples);
+        } else {
+            _pendingSamples = std::move(samples);
+        }
+    }
+    _datasetChanged.notify_all();
+}
+
+void TrainingWorker::replace(std::vector<size_t> indices, Dataset samples) {
+    {
+        std::lock_guard<std::mutex> lock(_datasetMutex);
+        if (_pendingDataset.has_value()) {
+            _pendingDataset->replace(indices, samples);
+        } else if (_pendingReplacements.has_value()) {
+            _pendingIndices.insert(_pendingIndices.end(), indices.begin(), indices.end());
+            _pendingReplacements->append(samples);
+        } else {
+            _pendingIndices = std::move(indices);
+            _pendingReplacements = std::move(samples);
+        }
+    }
+    _datasetChanged.notify_all();
+}
+
+void TrainingWorker::applyPendingDataset(bool wait) {
+    std::unique_lock<std::mutex> lock(_datasetMutex);
+
+    // Sleep while there is nothing to learn
+    if (wait) {
+        _datasetChanged.wait(lock, [this]() {
+            return !_running || _pendingDataset.has_value() || _pendingSamples.has_value() ||
+                   _pendingReplacements.has_value() ||
+                   !_dataset.empty();
+        });
+    }
+
+    // The device memory of the dataset is kept, so only new samples are uploaded
+    if (_pendingDataset.has_value()) {
+        _dataset.assign(std::move(*_pendingDataset));
+        _pendingDataset.reset();
+    }
+    if (_pendingSamples.has_value()) {
+        _dataset.append(*_pendingSamples);
+        _pendingSamples.reset();
+    }
+
+    // Replacements only refer to samples that were handed over before, so they can follow the appended ones
+    if (_pendingReplacements.has_value()) {
+        _dataset.replace(_pendingIndices, *_pendingReplacements);
+        _pendingIndices.clear();
+        _pendingReplacements.reset();
+    }
+}
+
+void TrainingWorker::run() {
+    af::setDevice(_device);
+
+    try {
+        while (_running) {
+            applyPendingDataset(true);
+
+            if (!_running || _dataset.empty()) {
+                continue;
+            }
+
+            _trainer.step();
+            publish();
+        }
+    } catch (const af::exception &e) {
+        std::cerr << "The training stopped: " << e.what() << "\n";
+        _running = false;
+    }
+}
+
+void TrainingWorker::pump() {
+    if (_running) {
+        return;
+    }
+
+    applyPendingDataset(false);
+
+    if (_scheduler.run() > 0) {
+        publish();
+    }
+}
+
+void TrainingWorker::publish() {
+    NeuralNetwork &network = _trainer.network();
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->version = ++_version;
+    snapshot->statistics = _trainer.statistics();
+    snapshot->champion = network.slice(0);
+    snapshot->networks = network.networks();
+    snapshot->bytes = network.bytes();
+
+    // The population overview costs some reductions, so it is only computed on request
+    if (_summaryRequested && snapshot->statistics.generation > 0) {
+        snapshot->summary = _trainer.summarize();
+        snapshot->hasSummary = true;
+    }
+
+    // The copies must be finished before other threads read them
+    af::sync();
+
+    // After the swap the local pointer holds the old snapshot, so it is released outside of the lock
+    std::shared_ptr<const Snapshot> published = std::move(snapshot);
+    {
+        std::lock_guard<std::mutex> lock(_snapshotMutex);
+        _snapshot.swap(published);
+    }
+}
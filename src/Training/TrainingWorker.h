@@ -0,0 +1,77 @@
+#ifndef KI_TRAININGWORKER_H
+#define KI_TRAININGWORKER_H
+
+#include <arrayfire.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <iostream>
+
+#include "Trainer.h"
+#include "Dataset.h"
+#include "Snapshot.h"
+#include "TrainingScheduler.h"
+
+// Runs the training on its own thread, or inside the render loop with pump(). After every generation an
+// immutable snapshot is published by swapping a shared pointer. The mutex only guards that pointer copy,
+// so readers wait at most for a swap and never for a generation.
+class TrainingWorker {
+private:
+    Trainer &_trainer;
+    Dataset &_dataset; // The source the trainer was created with, filled by the interface
+    TrainingScheduler _scheduler;
+    int _device;
+
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+
+    // Dataset handed over by the interface, it replaces the training data before the next generation.
+    // Samples handed over with append() are added to it instead, replace() overwrites single samples after that.
+    std::mutex _datasetMutex;
+    std::condition_variable _datasetChanged;
+    std::optional<Dataset> _pendingDataset;
+    std::optional<Dataset> _pendingSamples;
+    std::vector<size_t> _pendingIndices;
+    std::optional<Dataset> _pendingReplacements;
+
+    std::atomic<bool> _summaryRequested{false};
+
+    mutable std::mutex _snapshotMutex;
+    std::shared_ptr<const Snapshot> _snapshot;
+    uint64_t _version = 0;
+
+    void run();
+    void applyPendingDataset(bool wait);
+    void publish();
+
+public:
+    TrainingWorker(Trainer &trainer, Dataset &dataset, float frameBudget = 0.008f);
+    ~TrainingWorker();
+
+    TrainingWorker(const TrainingWorker &) = delete;
+    TrainingWorker &operator=(const TrainingWorker &) = delete;
+
+    void start();
+    void stop();
+    [[nodiscard]] bool running() const { return _running; }
+
+    // Trains on the calling thread within the frame budget, only used without start()
+    void pump();
+    [[nodiscard]] TrainingScheduler &scheduler() { return _scheduler; }
+
+    // Can be called from any thread
+    void submit(Dataset dataset);
+    void append(Dataset samples);
+    void replace(std::vector<size_t> indices, Dataset samples);
+    void requestSummary(bool value) { _summaryRequested = value; }
+    [[nodiscard]] std::shared_ptr<const Snapshot> snapshot() const {
+        std::lock_guard<std::mutex> lock(_snapshotMutex);
+        return _snapshot;
+    }
+};
+
+
+#endif //KI_TRAININGWORKER_H
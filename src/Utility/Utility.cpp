@@ -19,11 +19,11 @@ af::Backend Utility::_backend = af::Backend::AF_BACKEND_DEFAULT;
 bool Utility::_doubleSupport = false;
 int Utility::_availableDevices = 0;
 
-void Utility::setup() {
+void Utility::setup(af::Backend backend) {
 
     std::cout << "Setup...\n\n";
 
-    af::setBackend(AF_BACKEND_DEFAULT);       // GPU Backend
+    af::setBackend(backend);                        // GPU Backend by default
 
     int bestDevice = af::getDevice();               // Find the best graphics device
     af::setDevice(bestDevice);                      // Select the best graphics device
@@ -121,8 +121,8 @@ std::vector<std::vector<float>> Utility::arrayToVector2D(const af::array &array)
 
 std::string Utility::sizeToString(size_t size) {
     std::string out;
-    byte unit = 0;
-    byte komma = 0;
+    unsigned char unit = 0;
+    unsigned char komma = 0;
 
     while(size > 1000){
         int temp = size / 1000;
@@ -216,4 +216,44 @@ af::array Utility::mapArrayToIndices(const af::array& input) {
 
     // Return the indices of the maximum values
     return indices;
-}
\ No newline at end of file
+}
+
+bool Utility::parseBackend(std::string const &text, af::Backend &backend) {
+    if (text == "default") backend = AF_BACKEND_DEFAULT;
+    else if (text == "cpu") backend = AF_BACKEND_CPU;
+    else if (text == "cuda") backend = AF_BACKEND_CUDA;
+    else if (text == "opencl") backend = AF_BACKEND_OPENCL;
+    else return false;
+    return true;
+}
+
+af::array Utility::blockReduce(const af::array &matrix, int rowGroup, int colGroup, bool absMax) {
+    dim_t rows = matrix.dims(0);
+    dim_t cols = matrix.dims(1);
+    dim_t rowBlocks = (rows + rowGroup - 1) / rowGroup;
+    dim_t colBlocks = (cols + colGroup - 1) / colGroup;
+
+    // Pad with zeros to whole blocks, the mask counts the real elements of every block
+    af::array padded = af::constant(0.0f, rowBlocks * rowGroup, colBlocks * colGroup);
+    af::array mask = af::constant(0.0f, rowBlocks * rowGroup, colBlocks * colGroup);
+    padded(af::seq((double)rows), af::seq((double)cols)) = af::moddims(matrix, rows, cols);
+    mask(af::seq((double)rows), af::seq((double)cols)) = 1.0f;
+
+    // Reduce the rows of a block first, then its columns
+    auto reduce = [&](const af::array &values, int operation) {
+        af::array blocks = af::moddims(values, rowGroup, rowBlocks * colBlocks * colGroup);
+        blocks = (operation == 0) ? af::sum(blocks, 0) : (operation == 1) ? af::max(blocks, 0) : af::min(blocks, 0);
+        blocks = af::moddims(blocks, rowBlocks, colGroup, colBlocks);
+        blocks = (operation == 0) ? af::sum(blocks, 1) : (operation == 1) ? af::max(blocks, 1) : af::min(blocks, 1);
+        return af::moddims(blocks, rowBlocks, colBlocks);
+    };
+
+    if (!absMax) {
+        return reduce(padded, 0) / reduce(mask, 0);
+    }
+
+    // The zero padding never has a larger magnitude than the real values
+    af::array maximum = reduce(padded, 1);
+    af::array minimum = reduce(padded, 2);
+    return af::select(af::abs(maximum) >= af::abs(minimum), maximum, minimum);
+}
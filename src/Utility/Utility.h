@@ -8,6 +8,7 @@
 #include <arrayfire.h>
 #include <iostream>
 #include <algorithm>
+#include <cstring>
 
 class Utility{
 private:
@@ -27,7 +28,10 @@ public:
     };
 
     // Setup method
-    static void setup();
+    static void setup(af::Backend backend = AF_BACKEND_DEFAULT);
+
+    // Parses a backend name like "cpu" for the command line tools, returns false for unknown names
+    static bool parseBackend(std::string const &text, af::Backend &backend);
 
     // Calculate activation
     static af::array calculate_activation(af::array &values, Activations activation, bool derivative = false);
@@ -51,6 +55,9 @@ public:
     static af::array mapIndexToArray(int index, int size);
     static af::array mapArrayToIndices(const af::array& input);
 
+    // Reduces blocks of rowGroup x colGroup elements of a matrix to their mean or their value with the largest magnitude
+    static af::array blockReduce(const af::array &matrix, int rowGroup, int colGroup, bool absMax = false);
+
     // Getter and setter
     [[nodiscard]] static bool &initialized() { return _initialized; }
     [[nodiscard]] static char* deviceName() { return _deviceName; }
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <arrayfire.h>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#endif
+
+#include "Utility/Utility.h"
+#include "Benchmark/Benchmark.h"
+#include "Benchmark/Baseline.h"
+
+// Parses a comma separated list like "1000,10000,100000"
+std::vector<int> parseList(std::string const &text) {
+    std::vector<int> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+void printUsage() {
+    std::cerr << "Usage: Benchmark [--networks 1000,10000,100000,1000000] [--points 10,100,1000,10000,100000] "
+                 "[--generations 10] [--seed 42] [--output benchmark.csv] [--backend default|cpu|cuda|opencl] "
+                 "[--save-baseline <file.json>] [--compare <file.json>] [--runs 15] [--threshold 0.10] "
+                 "[--threshold-p95 0.25] [--threshold-memory 0.10] [--alpha 0.01]\n";
+}
+
+// Name of the backend that is actually active, so "default" is stored as the backend it resolved to
+std::string backendName(af::Backend backend) {
+    switch (backend) {
+        case AF_BACKEND_CPU: return "cpu";
+        case AF_BACKEND_CUDA: return "cuda";
+        case AF_BACKEND_OPENCL: return "opencl";
+        default: return "default";
+    }
+}
+
+int main(int argc, char **argv) {
+    // Scaling sweep from 1k to 1M networks and from 10 to 100k points
+    std::vector<int> networks = {1000, 10000, 100000, 1000000};
+    std::vector<int> points = {10, 100, 1000, 10000, 100000};
+    int generations = 10;
+    unsigned int seed = 42;
+    std::string output = "benchmark.csv";
+    af::Backend backend = AF_BACKEND_DEFAULT;
+
+    // Regression gate
+    std::string saveBaseline;
+    std::string compareBaseline;
+    int runs = 15;
+    Baseline::Thresholds thresholds;
+
+    for (int i = 1; i < argc; i += 2) {
+        std::string option = argv[i];
+        // Every option takes a value, a flag without one is an error instead of being dropped
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for option: " << option << "\n";
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[i + 1];
+
+        if (option == "--networks") {
+            networks = parseList(value);
+        } else if (option == "--points") {
+            points = parseList(value);
+        } else if (option == "--generations") {
+            generations = std::stoi(value);
+        } else if (option == "--seed") {
+            seed = std::stoul(value);
+        } else if (option == "--output") {
+            output = value;
+        } else if (option == "--backend") {
+            if (!Utility::parseBackend(value, backend)) {
+                std::cerr << "Unknown backend: " << value << "\n";
+                return 1;
+            }
+        } else if (option == "--save-baseline") {
+            saveBaseline = value;
+        } else if (option == "--compare") {
+            compareBaseline = value;
+        } else if (option == "--runs") {
+            runs = std::stoi(value);
+        } else if (option == "--threshold") {
+            thresholds.median = std::stof(value);
+        } else if (option == "--threshold-p95") {
+            thresholds.p95 = std::stof(value);
+        } else if (option == "--threshold-memory") {
+            thresholds.memory = std::stof(value);
+        } else if (option == "--alpha") {
+            thresholds.alpha = std::stof(value);
+        } else {
+            std::cerr << "Unknown option: " << option << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    // Setup the environment
+    Utility::setup(backend);
+
+    // Same network as the interactive application
+    std::vector<int> topology = {2, 5, 5, 2};
+    std::vector<Utility::Activations> activations = {
+            Utility::Activations::Tanh,
+            Utility::Activations::Tanh,
+            Utility::Activations::Tanh
+    };
+
+    Benchmark benchmark(topology, activations);
+
+    // Gate mode: record or compare the small feed_forward, breed and generation benchmarks
+    if (!saveBaseline.empty() || !compareBaseline.empty()) {
+        auto measurements = benchmark.gate(runs, seed);
+        std::string active = backendName(Utility::backend());
+
+        for (auto &measurement : measurements) {
+            std::cout << measurement.name << ": median " << measurement.median() * 1000.0f << " ms, p95 "
+                      << measurement.p95() * 1000.0f << " ms, memory "
+                      << Utility::sizeToString(measurement.peakDeviceBytes) << "\n";
+        }
+
+        if (!saveBaseline.empty()) {
+            Baseline baseline(active, Utility::deviceName(), measurements);
+            if (!baseline.save(saveBaseline)) {
+                return 1;
+            }
+            std::cout << "Baseline written to " << saveBaseline << "\n";
+        }
+
+        if (!compareBaseline.empty()) {
+            Baseline baseline;
+            if (!baseline.load(compareBaseline)) {
+                return 1;
+            }
+            // A non-zero exit code fails the gate
+            return baseline.compare(measurements, thresholds, active, Utility::deviceName()) ? 0 : 1;
+        }
+        return 0;
+    }
+
+    std::vector<Benchmark::Result> results;
+    for (auto &scenario : Benchmark::scalingSweep(networks, points, generations, seed)) {
+        results.push_back(benchmark.run(scenario));
+        Benchmark::print(results.back());
+    }
+
+    if (!Benchmark::save(output, results)) {
+        return 1;
+    }
+
+    std::cout << "Results written to " << output << "\n";
+    return 0;
+}
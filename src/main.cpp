@@ -7,6 +7,9 @@
 
 #include "Utility/Utility.h"
 #include "NeuralNetwork/NeuralNetwork.h"
+#include "Training/Dataset.h"
+#include "Training/Trainer.h"
+#include "Training/TrainingWorker.h"
 #include "Interfaces/NetworkViewer/NetworkViewer.h"
 #include "Interfaces/DrawingApp/DrawingApp.h"
 
@@ -24,25 +27,51 @@ int main() {
 
     // Initialize the neural network
     NeuralNetwork network(topology, activations, -2.8f, 2.8f, true, networks);
+    network.crossover(NeuralNetwork::Crossover::Uniform);
 
     std::cout << "Saving... \n";
     //network.save("testFile");
     std::cout << "Done saving!\n";
 
-    NetworkViewer viewer({1000, 800}, "Neural-Network-Viewer", network);
-    DrawingApp drawing({800, 800}, "Drawing App", network);
+    // The training runs on its own thread, the windows only render its latest snapshot.
+    // Without a background thread it runs inside the render loop within a time budget per frame.
+    bool backgroundTraining = true;
+    float frameBudget = 0.008f;
+    size_t miniBatch = 0;      // Random points per generation instead of all drawn points, 0 uses all
+    float smoothing = 0.0f;    // Moving average of the winners' errors over the mini-batches
+    bool adaptive = false;     // Every network tunes its own mutation strength, starting from the trainer's range
+
+    network.adaptiveMutation(adaptive);
+
+    Dataset dataset(topology.front(), topology.back());
+    Trainer trainer(network, dataset, 500, -0.05f, +0.05f);
+    trainer.miniBatch(miniBatch, smoothing);
+    TrainingWorker worker(trainer, dataset, frameBudget);
+
+    NetworkViewer viewer({1000, 800}, "Neural-Network-Viewer", worker);
+    DrawingApp drawing({800, 800}, "Drawing App", worker);
 
     viewer.setFramerateLimit(144);
     drawing.setFramerateLimit(144);
 
+    if (backgroundTraining) {
+        worker.start();
+    }
+
     // Stops when a window is closed
     while (drawing.isOpen() && viewer.isOpen()) {
         // This code runs every Frame
+        if (!backgroundTraining) {
+            worker.pump();
+        }
+
         viewer.update();
         viewer.render();
         drawing.update();
         drawing.render();
     }
 
+    worker.stop();
+
     return 0;
 }
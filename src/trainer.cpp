@@ -0,0 +1,299 @@
+#include <iostream>
+#include <arrayfire.h>
+#include <sstream>
+#include <fstream>
+#include <csignal>
+#include <atomic>
+
+#ifdef _WIN32
+#define NOMINMAX
+#endif
+
+#include "Utility/Utility.h"
+#include "NeuralNetwork/NeuralNetwork.h"
+#include "Training/Dataset.h"
+#include "Training/StreamingDataset.h"
+#include "Training/Trainer.h"
+
+// Set by Ctrl+C, the training stops after the current generation and writes a last checkpoint
+std::atomic<bool> stopRequested(false);
+
+void requestStop(int) {
+    stopRequested = true;
+}
+
+// Parses a comma separated list like "2,5,5,2"
+std::vector<std::string> parseList(std::string const &text) {
+    std::vector<std::string> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        values.push_back(item);
+    }
+    return values;
+}
+
+bool parseActivation(std::string const &text, Utility::Activations &activation) {
+    if (text == "relu") activation = Utility::Activations::ReLU;
+    else if (text == "leakyrelu") activation = Utility::Activations::LeakyReLU;
+    else if (text == "sigmoid") activation = Utility::Activations::Sigmoid;
+    else if (text == "linear") activation = Utility::Activations::Linear;
+    else if (text == "tanh") activation = Utility::Activations::Tanh;
+    else return false;
+    return true;
+}
+
+bool parseCrossover(std::string const &text, NeuralNetwork::Crossover &crossover) {
+    if (text == "uniform") crossover = NeuralNetwork::Crossover::Uniform;
+    else if (text == "neuron") crossover = NeuralNetwork::Crossover::Neuron;
+    else if (text == "layer") crossover = NeuralNetwork::Crossover::Layer;
+    else if (text == "point") crossover = NeuralNetwork::Crossover::SinglePoint;
+    else if (text == "two-point") crossover = NeuralNetwork::Crossover::TwoPoint;
+    else if (text == "arithmetic") crossover = NeuralNetwork::Crossover::Arithmetic;
+    else return false;
+    return true;
+}
+
+void printUsage() {
+    std::cerr << "Usage: Trainer --data <file.csv> [--topology 2,5,5,2] [--activations tanh,tanh,tanh] "
+                 "[--networks 50000] [--winners 500] [--mutation 0.05] [--generations 0] [--load <file.json>] "
+                 "[--checkpoint checkpoint.json] [--checkpoint-every 100] [--checkpoint-networks 1] "
+                 "[--stats stats.csv] [--print-every 10] [--backend default|cpu|cuda|opencl] [--seed <n>] "
+                 "[--format csv|binary] [--import <file.csv>] [--chunk 65536] [--racing 0.5] "
+                 "[--mini-batch 256] [--smoothing 0.5] [--deduplicate 1e-6] "
+                 "[--crossover uniform|neuron|layer|point|two-point|arithmetic] [--adaptive-mutation 0]\n";
+}
+
+int main(int argc, char **argv) {
+    // Same defaults as the interactive application
+    std::string data;
+    std::vector<int> topology = {2, 5, 5, 2};
+    std::vector<Utility::Activations> activations = {
+            Utility::Activations::Tanh,
+            Utility::Activations::Tanh,
+            Utility::Activations::Tanh
+    };
+    int networks = 50000;
+    int winners = 500;
+    float mutation = 0.05f;
+    int generations = 0; // 0 trains until Ctrl+C
+    std::string load;
+    std::string checkpoint = "checkpoint.json";
+    int checkpointEvery = 100;
+    int checkpointNetworks = 1;
+    std::string stats = "stats.csv";
+    int printEvery = 10;
+    af::Backend backend = AF_BACKEND_DEFAULT;
+    long long seed = -1;
+    std::string format = "csv";    // binary streams a memory-mapped file in chunks
+    std::string import;            // CSV file converted into the binary --data file first
+    size_t chunk = 1 << 16;
+    size_t miniBatch = 0;          // Random samples per generation, 0 uses all
+    float smoothing = 0.0f;        // Moving average of the winners' errors over the mini-batches
+    float racing = 0.0f;           // Part of the networks kept per racing round, 0 evaluates every network fully
+    float deduplicate = 0.0f;      // Quantum of the genome fingerprints, 0 evaluates duplicates separately
+    NeuralNetwork::Crossover crossover = NeuralNetwork::Crossover::Uniform;
+    float adaptive = -1.0f;        // Rate of the self-adaptive mutation strength, 0 uses 1 / sqrt(parameters)
+
+    for (int i = 1; i < argc; i += 2) {
+        std::string option = argv[i];
+        // Every option takes a value, a flag without one is an error instead of being dropped
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for option: " << option << "\n";
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[i + 1];
+
+        if (option == "--data") {
+            data = value;
+        } else if (option == "--topology") {
+            topology.clear();
+            for (auto &item : parseList(value)) {
+                topology.push_back(std::stoi(item));
+            }
+        } else if (option == "--activations") {
+            activations.clear();
+            for (auto &item : parseList(value)) {
+                Utility::Activations activation;
+                if (!parseActivation(item, activation)) {
+                    std::cerr << "Unknown activation: " << item << "\n";
+                    return 1;
+                }
+                activations.push_back(activation);
+            }
+        } else if (option == "--networks") {
+            networks = std::stoi(value);
+        } else if (option == "--winners") {
+            winners = std::stoi(value);
+        } else if (option == "--mutation") {
+            mutation = std::stof(value);
+        } else if (option == "--generations") {
+            generations = std::stoi(value);
+        } else if (option == "--load") {
+            load = value;
+        } else if (option == "--checkpoint") {
+            checkpoint = value;
+        } else if (option == "--checkpoint-every") {
+            checkpointEvery = std::stoi(value);
+        } else if (option == "--checkpoint-networks") {
+            checkpointNetworks = std::stoi(value);
+        } else if (option == "--stats") {
+            stats = value;
+        } else if (option == "--print-every") {
+            printEvery = std::stoi(value);
+        } else if (option == "--backend") {
+            if (!Utility::parseBackend(value, backend)) {
+                std::cerr << "Unknown backend: " << value << "\n";
+                return 1;
+            }
+        } else if (option == "--seed") {
+            seed = std::stoll(value);
+        } else if (option == "--format") {
+            format = value;
+        } else if (option == "--import") {
+            import = value;
+            format = "binary";
+        } else if (option == "--chunk") {
+            chunk = std::stoull(value);
+        } else if (option == "--mini-batch") {
+            miniBatch = std::stoull(value);
+        } else if (option == "--smoothing") {
+            smoothing = std::stof(value);
+        } else if (option == "--racing") {
+            racing = std::stof(value);
+        } else if (option == "--deduplicate") {
+            deduplicate = std::stof(value);
+        } else if (option == "--adaptive-mutation") {
+            adaptive = std::stof(value);
+        } else if (option == "--crossover") {
+            if (!parseCrossover(value, crossover)) {
+                std::cerr << "Unknown crossover: " << value << "\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Unknown option: " << option << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (data.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    if (topology.size() < 2 || activations.size() != topology.size() - 1) {
+        std::cerr << "The topology needs one activation per layer!\n";
+        return 1;
+    }
+
+    // Setup the environment
+    Utility::setup(backend);
+    std::cout << "Device: " << Utility::deviceName() << " (" << Utility::platform() << ")\n";
+
+    // Small datasets are kept on the device, large binary ones are streamed from disk
+    Dataset dataset(topology.front(), topology.back());
+    StreamingDataset streaming(chunk);
+    DataSource *source = &dataset;
+
+    if (format == "binary") {
+        if (!import.empty() && !StreamingDataset::import(import, data, topology.front(), topology.back())) {
+            std::cerr << "The dataset " << import << " could not be converted!\n";
+            return 1;
+        }
+        if (!streaming.open(data) || streaming.empty()) {
+            std::cerr << "The dataset " << data << " could not be loaded!\n";
+            return 1;
+        }
+        if (streaming.inputSize() != topology.front() || streaming.outputSize() != topology.back()) {
+            std::cerr << "The dataset " << data << " does not match the topology!\n";
+            return 1;
+        }
+        source = &streaming;
+    } else if (!dataset.load(data) || dataset.empty()) {
+        std::cerr << "The dataset " << data << " could not be loaded!\n";
+        return 1;
+    }
+    std::cout << "Loaded " << source->size() << " samples from " << data << "\n";
+
+    if (seed >= 0) {
+        af::setSeed(seed);
+    }
+
+    NeuralNetwork network(topology, activations, -2.8f, 2.8f, true, networks);
+    if (seed >= 0) {
+        network.seed(seed);
+    }
+    network.crossover(crossover);
+    if (adaptive >= 0.0f) {
+        network.adaptiveMutation(true, adaptive);
+    }
+    if (!load.empty()) {
+        if (!network.load(load)) {
+            return 1;
+        }
+        // The saved networks bring their own topology, which has to fit the dataset
+        std::vector<int> loaded = network.topology();
+        if (loaded.front() != source->inputSize() || loaded.back() != source->outputSize()) {
+            std::cerr << "The networks in " << load << " have " << loaded.front() << " inputs and " << loaded.back()
+                      << " outputs, but the dataset has " << source->inputSize() << " and " << source->outputSize()
+                      << "!\n";
+            return 1;
+        }
+    }
+
+    Trainer trainer(network, *source, winners, -mutation, +mutation);
+    trainer.miniBatch(miniBatch, smoothing);
+    if (racing > 0.0f) {
+        trainer.racing(true, racing);
+        if (deduplicate > 0.0f) {
+            std::cerr << "Warning: --racing evaluates every survivor itself, --deduplicate and the fitness cache are "
+                         "turned off\n";
+        }
+    }
+    if (deduplicate > 0.0f) {
+        trainer.deduplicate(true, deduplicate);
+    }
+
+    std::ofstream statsFile(stats);
+    if (!statsFile.is_open()) {
+        std::cerr << "Failed to open file for writing: " << stats << "\n";
+        return 1;
+    }
+    statsFile << "generation,best_error,mean_error,seconds,evaluations,duplicates,mutation\n";
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Train as fast as the device allows
+    while (!stopRequested && (generations <= 0 || trainer.statistics().generation < generations)) {
+        Trainer::Statistics statistics = trainer.step();
+
+        statsFile << statistics.generation << "," << statistics.bestError << ","
+                  << statistics.meanError << "," << statistics.seconds << "," << statistics.evaluations << ","
+                  << statistics.duplicates << "," << statistics.mutation << "\n";
+
+        if (printEvery > 0 && statistics.generation % printEvery == 0) {
+            float elapsed = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+            std::cout << "Generation " << statistics.generation << ": best error " << statistics.bestError
+                      << ", mean error " << statistics.meanError << ", "
+                      << (float)statistics.generation / elapsed << " generations/s\n";
+        }
+
+        if (checkpointEvery > 0 && statistics.generation % checkpointEvery == 0) {
+            // The best networks are at the front after breeding
+            network.save(checkpoint, checkpointNetworks);
+            statsFile.flush();
+        }
+    }
+
+    network.save(checkpoint, checkpointNetworks);
+    statsFile.close();
+
+    std::cout << "Stopped after " << trainer.statistics().generation << " generations, checkpoint written to "
+              << checkpoint << "\n";
+    return 0;
+}